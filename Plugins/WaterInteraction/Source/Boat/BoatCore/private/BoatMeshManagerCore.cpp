@@ -1,53 +1,246 @@
 #pragma once
 #include "BoatMeshManagerCore.h"
 #include "Async/ParallelFor.h"
+#include "Math/VectorRegister.h"
+
+namespace
+{
+    constexpr int32 TransformChunkSize = 1024;
+}
+
+/// <summary>
+/// Sizes the world space buffers for the hull. The hull never changes after it is built,
+/// so the indices are validated here once instead of every tick.
+/// </summary>
+void BoatMeshManagerCore::AllocateWorldBuffers()
+{
+    const HullData& hull = *Hull;
+    check(hull.Indices.Num() % 3 == 0);
+    for (int32 idx = 0; idx < hull.Indices.Num(); idx += 3)
+    {
+        check(hull.Indices[idx] != hull.Indices[idx + 1] && hull.Indices[idx] != hull.Indices[idx + 2] && hull.Indices[idx + 1] != hull.Indices[idx + 2]);
+    }
+    const int32 numTriangles = hull.Indices.Num() / 3;
+    const int32 clusteredTriangles = hull.Clusters.Num() > 0 ? hull.Clusters.Last().FirstTriangle + hull.Clusters.Last().NumTriangles : 0;
+    check(clusteredTriangles == numTriangles && hull.TriangleNormals.Num() == numTriangles && hull.TriangleAreas.Num() == numTriangles);
+    WorldVertices.SetNumUninitialized(hull.NumVertices());
+    VertexWaterHeights.SetNumUninitialized(hull.NumVertices());
+    VertexNeedsWater.SetNumUninitialized(hull.NumVertices());
+    WorldTriangles.Vertex1.SetNumUninitialized(numTriangles);
+    WorldTriangles.Vertex2.SetNumUninitialized(numTriangles);
+    WorldTriangles.Vertex3.SetNumUninitialized(numTriangles);
+    WorldTriangles.WaterHeight1.SetNumUninitialized(numTriangles);
+    WorldTriangles.WaterHeight2.SetNumUninitialized(numTriangles);
+    WorldTriangles.WaterHeight3.SetNumUninitialized(numTriangles);
+    WorldTriangles.Normal.SetNumUninitialized(numTriangles);
+    WorldTriangles.Area.SetNumUninitialized(numTriangles);
+    WorldTriangles.ClusterStates.SetNumUninitialized(hull.Clusters.Num());
+}
 
 /// <summary>
 /// This function calculates the global hull triangles based on the local vertices and indices.
 /// Global coordinates change every frame based on the boat's transform.
+/// Every unique vertex is transformed once with the hull matrix, for a quantized hull the dequantization is folded into the matrix, then the triangles gather their corners into their own slot,
+/// so neither pass needs a lock and the triangle order always matches the index buffer.
+/// In between, every cluster whose world bounds are above the highest water the surface reports under them is marked dry,
+/// and the water is sampled once per unique vertex of the remaining clusters, triangles sharing a vertex share its sample.
+/// The gather runs per cluster and classifies the rest against the samples: dry when the lowest corner is above the highest
+/// water of its corners, submerged when the highest corner is below the lowest water, and straddling otherwise.
+/// Triangles of clusters that can touch the water also get their world normal and area. Under a uniform scale they are the
+/// precomputed local ones rotated and scaled, otherwise they are computed from the world corners.
 /// </summary>
-/// <param name="globalHullTriangles"></param>
-void BoatMeshManagerCore::CalculateGlobalHullTriangles(TriangleInfoList& globalHullTriangles) const
+/// <param name="hullTransform">Component transform of the hull mesh, taken once per tick with the rest of the hull state</param>
+/// <param name="waterSurface">May be null, the hull is then entirely dry</param>
+/// <param name="time"></param>
+/// <returns>View of the world space triangles, valid until the next call</returns>
+HullTrianglesView BoatMeshManagerCore::CalculateGlobalHullTriangles(const FTransform& hullTransform, const IWaterSurface* waterSurface, float time)
 {
     TRACE_CPUPROFILER_EVENT_SCOPE(UBoatForceComponent::CalculateGlobalHullTriangles);
+    if (!Hull.IsValid() || Hull->IsEmpty())
+    {
+        return HullTrianglesView();
+    }
+    const HullData& hull = *Hull;
+    if (WorldVertices.Num() != hull.NumVertices() || WorldTriangles.Num() * 3 != hull.Indices.Num())
+    {
+        AllocateWorldBuffers();
+    }
 
-    static int actorId = 0;
-    const auto& BoatTransform = HullMesh->GetComponentTransform(); //Using Actor transform previously but this is better since this is more accurate.
+    //Using Actor transform previously but this is better since this is more accurate.
+    const FMatrix boatMatrix = hullTransform.ToMatrixWithScale();
+    const VectorRegister4Double row0 = VectorLoad(&boatMatrix.M[0][0]);
+    const VectorRegister4Double row1 = VectorLoad(&boatMatrix.M[1][0]);
+    const VectorRegister4Double row2 = VectorLoad(&boatMatrix.M[2][0]);
+    const VectorRegister4Double row3 = VectorLoad(&boatMatrix.M[3][0]);
+    const FVector boatScale = hullTransform.GetScale3D();
+    const bool uniformScale = boatScale.AllComponentsEqual(UE_KINDA_SMALL_NUMBER) && !FMath::IsNearlyZero(boatScale.X);
+    const double invScale = uniformScale ? 1.0 / boatScale.X : 0.0;
+    const float areaScale = static_cast<float>(boatScale.X * boatScale.X);
 
-    UE_LOG(LogTemp, Warning, TEXT("Actor Location %d : %s"), actorId, *BoatTransform.GetLocation().ToString());
-    //Get local vertices and convert to world coordinates
-    check(globalHullTriangles.Items.Num() == 0); //The list should not be already populated.
+    const int32 numVertices = hull.NumVertices();
+    const int32 numVertexChunks = FMath::DivideAndRoundUp(numVertices, TransformChunkSize);
+    if (hull.IsQuantized())
+    {
+        // local = quantized * scale + offset, so the scale goes into the axis rows and the offset into the translation
+        const FVector& scale = hull.QuantizationScale;
+        const FVector& offset = hull.QuantizationOffset;
+        const VectorRegister4Double quantizedRow0 = VectorMultiply(row0, VectorLoadFloat1(&scale.X));
+        const VectorRegister4Double quantizedRow1 = VectorMultiply(row1, VectorLoadFloat1(&scale.Y));
+        const VectorRegister4Double quantizedRow2 = VectorMultiply(row2, VectorLoadFloat1(&scale.Z));
+        VectorRegister4Double quantizedRow3 = VectorMultiplyAdd(VectorLoadFloat1(&offset.X), row0, row3);
+        quantizedRow3 = VectorMultiplyAdd(VectorLoadFloat1(&offset.Y), row1, quantizedRow3);
+        quantizedRow3 = VectorMultiplyAdd(VectorLoadFloat1(&offset.Z), row2, quantizedRow3);
+        ParallelFor(numVertexChunks, [&](int32 chunk)
+            {
+                const int32 chunkEnd = FMath::Min((chunk + 1) * TransformChunkSize, numVertices);
+                for (int32 i = chunk * TransformChunkSize; i < chunkEnd; ++i)
+                {
+                    const QuantizedHullVertex& local = hull.QuantizedVertices[i];
+                    const double x = local.X;
+                    const double y = local.Y;
+                    const double z = local.Z;
+                    VectorRegister4Double world = VectorMultiplyAdd(VectorLoadFloat1(&x), quantizedRow0, quantizedRow3);
+                    world = VectorMultiplyAdd(VectorLoadFloat1(&y), quantizedRow1, world);
+                    world = VectorMultiplyAdd(VectorLoadFloat1(&z), quantizedRow2, world);
+                    VectorStoreFloat3(world, &WorldVertices[i].X);
+                }
+            });
+    }
+    else
+    {
+        ParallelFor(numVertexChunks, [&](int32 chunk)
+            {
+                const int32 chunkEnd = FMath::Min((chunk + 1) * TransformChunkSize, numVertices);
+                for (int32 i = chunk * TransformChunkSize; i < chunkEnd; ++i)
+                {
+                    const FVector& local = hull.Vertices[i];
+                    VectorRegister4Double world = VectorMultiplyAdd(VectorLoadFloat1(&local.X), row0, row3);
+                    world = VectorMultiplyAdd(VectorLoadFloat1(&local.Y), row1, world);
+                    world = VectorMultiplyAdd(VectorLoadFloat1(&local.Z), row2, world);
+                    VectorStoreFloat3(world, &WorldVertices[i].X);
+                }
+            });
+    }
 
-    FCriticalSection Mutex;
-    ParallelFor(LocalIndices.Num(), [&](int32_t idx)
+    // Marking is cheap next to sampling, it stays serial so the flags are written by one thread
+    FMemory::Memzero(VertexNeedsWater.GetData(), VertexNeedsWater.Num() * sizeof(bool));
+    for (int32 clusterIndex = 0; clusterIndex < hull.Clusters.Num(); ++clusterIndex)
+    {
+        const HullCluster& cluster = hull.Clusters[clusterIndex];
+        EHullClusterState& state = WorldTriangles.ClusterStates[clusterIndex];
+        state = EHullClusterState::Straddling;
+        if (waterSurface == nullptr)
         {
-            if (idx + 2 >= LocalIndices.Num())
+            state = EHullClusterState::Dry;
+            continue;
+        }
+        const FBox worldBounds = cluster.LocalBounds.TransformBy(boatMatrix);
+        const FFloatInterval heightBounds = waterSurface->GetHeightBounds(FBox2D(FVector2D(worldBounds.Min), FVector2D(worldBounds.Max)), time);
+        if (!heightBounds.IsValid() || worldBounds.Min.Z >= heightBounds.Max)
+        {
+            state = EHullClusterState::Dry;
+            continue;
+        }
+        for (int32 idx = 3 * cluster.FirstTriangle; idx < 3 * (cluster.FirstTriangle + cluster.NumTriangles); ++idx)
+        {
+            VertexNeedsWater[hull.Indices[idx]] = true;
+        }
+    }
+
+    ParallelFor(numVertexChunks, [&](int32 chunk)
+        {
+            const int32 chunkEnd = FMath::Min((chunk + 1) * TransformChunkSize, numVertices);
+            constexpr int32 SampleBlockSize = 64;
+            int32 blockIndices[SampleBlockSize];
+            FVector2D vertexXY[SampleBlockSize];
+            FWaterSample waterSamples[SampleBlockSize];
+            int32 blockCount = 0;
+            auto sampleBlock = [&]()
+                {
+                    waterSurface->SampleHeights(MakeArrayView(vertexXY, blockCount), time, MakeArrayView(waterSamples, blockCount));
+                    for (int32 i = 0; i < blockCount; ++i)
+                    {
+                        VertexWaterHeights[blockIndices[i]] = waterSamples[i].IsValid ? waterSamples[i].Position.Z : TNumericLimits<float>::Lowest();
+                    }
+                    blockCount = 0;
+                };
+            for (int32 i = chunk * TransformChunkSize; i < chunkEnd; ++i)
             {
-                return;
+                if (!VertexNeedsWater[i])
+                {
+                    VertexWaterHeights[i] = TNumericLimits<float>::Lowest();
+                    continue;
+                }
+                blockIndices[blockCount] = i;
+                vertexXY[blockCount] = FVector2D(WorldVertices[i]);
+                if (++blockCount == SampleBlockSize)
+                {
+                    sampleBlock();
+                }
             }
-            if (idx % 3 != 0)
+            if (blockCount > 0)
             {
-                return;
+                sampleBlock();
+            }
+        });
+
+    ParallelFor(hull.Clusters.Num(), [&](int32 clusterIndex)
+        {
+            const HullCluster& cluster = hull.Clusters[clusterIndex];
+            EHullClusterState& state = WorldTriangles.ClusterStates[clusterIndex];
+            const bool needsGeometry = state != EHullClusterState::Dry;
+            float minVertexZ = TNumericLimits<float>::Max();
+            float maxVertexZ = TNumericLimits<float>::Lowest();
+            float minWaterHeight = TNumericLimits<float>::Max();
+            float maxWaterHeight = TNumericLimits<float>::Lowest();
+            for (int32 triangle = cluster.FirstTriangle; triangle < cluster.FirstTriangle + cluster.NumTriangles; ++triangle)
+            {
+                const uint32 index1 = hull.Indices[3 * triangle];
+                const uint32 index2 = hull.Indices[3 * triangle + 1];
+                const uint32 index3 = hull.Indices[3 * triangle + 2];
+                WorldTriangles.Vertex1[triangle] = WorldVertices[index1];
+                WorldTriangles.Vertex2[triangle] = WorldVertices[index2];
+                WorldTriangles.Vertex3[triangle] = WorldVertices[index3];
+                WorldTriangles.WaterHeight1[triangle] = VertexWaterHeights[index1];
+                WorldTriangles.WaterHeight2[triangle] = VertexWaterHeights[index2];
+                WorldTriangles.WaterHeight3[triangle] = VertexWaterHeights[index3];
+                if (needsGeometry && uniformScale)
+                {
+                    WorldTriangles.Normal[triangle] = boatMatrix.TransformVector(FVector(hull.TriangleNormals[triangle])) * invScale;
+                    WorldTriangles.Area[triangle] = hull.TriangleAreas[triangle] * areaScale;
+                }
+                else if (needsGeometry)
+                {
+                    const FVector cross = (WorldVertices[index2] - WorldVertices[index1]) ^ (WorldVertices[index3] - WorldVertices[index1]);
+                    WorldTriangles.Normal[triangle] = cross.GetSafeNormal();
+                    WorldTriangles.Area[triangle] = 0.5f * cross.Size();
+                }
+                for (const uint32 index : { index1, index2, index3 })
+                {
+                    minVertexZ = FMath::Min<float>(minVertexZ, WorldVertices[index].Z);
+                    maxVertexZ = FMath::Max<float>(maxVertexZ, WorldVertices[index].Z);
+                    minWaterHeight = FMath::Min(minWaterHeight, VertexWaterHeights[index]);
+                    maxWaterHeight = FMath::Max(maxWaterHeight, VertexWaterHeights[index]);
+                }
+            }
+            if (!needsGeometry)
+            {
+                return; // Culled by the height bounds of the water
+            }
+            if (minVertexZ >= maxWaterHeight)
+            {
+                state = EHullClusterState::Dry;
+            }
+            else if (maxVertexZ < minWaterHeight)
+            {
+                state = EHullClusterState::Submerged;
             }
             else
             {
-                uint32 tri_index1 = LocalIndices[idx];
-                uint32 tri_index2 = LocalIndices[idx + 1];
-                uint32 tri_index3 = LocalIndices[idx + 2];
-                check(tri_index1 != tri_index2 && tri_index1 != tri_index3 && tri_index2 != tri_index3);
-                FVector localTriVertex1 = LocalVertices[tri_index1];
-                FVector localTriVertex2 = LocalVertices[tri_index2];
-                FVector localTriVertex3 = LocalVertices[tri_index3];
-                check(localTriVertex1 != localTriVertex2 && localTriVertex1 != localTriVertex3 && localTriVertex2 != localTriVertex3);
-                FVector TriVertex1 = BoatTransform.TransformPosition(localTriVertex1);
-                FVector TriVertex2 = BoatTransform.TransformPosition(localTriVertex2);
-                FVector TriVertex3 = BoatTransform.TransformPosition(localTriVertex3);
-                check(TriVertex1 != TriVertex2 && TriVertex1 != TriVertex3 && TriVertex2 != TriVertex3);
-                Mutex.Lock();
-                globalHullTriangles.Items.Add(TriangleInfo{ TriVertex1,TriVertex2,TriVertex3 });
-                Mutex.Unlock();
+                state = EHullClusterState::Straddling;
             }
         });
+    return HullTrianglesView(WorldTriangles, hull.Clusters);
 }
 
 /// <summary>
@@ -64,109 +257,38 @@ FVector BoatMeshManagerCore::GetRudderTransform() const
 }
 
 /// <summary>
-/// Get the local transform of the rudder based on the boat's orientation.
+/// Get the local transform of the rudder based on the boat's orientation. It sits at the stern, at the bottom
+/// and on the centre line of the hull, none of them further in than the mesh origin.
 /// </summary>
 /// <returns></returns>
 FVector BoatMeshManagerCore::CalcLocalRudderTransform() const
 {
-    FVector rudderLocalLocation;
+    FVector rudderLocalLocation = FVector::ZeroVector;
+    if (!Hull.IsValid())
+    {
+        return rudderLocalLocation;
+    }
+    const FBox& bounds = Hull->MeshBounds;
+    const FVector& centroid = Hull->MeshCentroid;
+    const double lowestZ = FMath::Min(bounds.Min.Z, 0.0);
     //Need to know how the boat is oriented.
     Direction forwardDirection = getBoatForwardDirection(); // +/-  Y Axis,X Axis
     switch (forwardDirection)
     {
     case PositiveX:
-    {
-        float LowestXPosition{ 0.0f };
-        float LowestZPosition{ 0.0f };
-        float totalYPositions{ 0.0f };
-
-        for (const auto& vert : LocalVertices)
-        {
-            if (vert.X < LowestXPosition)
-            {
-                LowestXPosition = vert.X;
-            }
-            if (vert.Z < LowestZPosition)
-            {
-                LowestZPosition = vert.Z;
-            }
-            totalYPositions += vert.Y;
-        }
-
-        rudderLocalLocation = FVector{ LowestXPosition, totalYPositions / LocalVertices.Num(), LowestZPosition };
-       
+        rudderLocalLocation = FVector{ FMath::Min(bounds.Min.X, 0.0), centroid.Y, lowestZ };
         break;
-    }
     case NegativeX:
-    {
-        float HighestXPosition{ 0.0f };
-        float LowestZPosition{ 0.0f };
-        float totalYPositions{ 0.0f };
-
-        for (const auto& vert : LocalVertices)
-        {
-            if (vert.X > HighestXPosition)
-            {
-                HighestXPosition = vert.X;
-            }
-            if (vert.Z < LowestZPosition)
-            {
-                LowestZPosition = vert.Z;
-            }
-            totalYPositions += vert.Y;
-        }
-
-        rudderLocalLocation = FVector{ HighestXPosition, totalYPositions / LocalVertices.Num(), LowestZPosition };
-
+        rudderLocalLocation = FVector{ FMath::Max(bounds.Max.X, 0.0), centroid.Y, lowestZ };
         break;
-    }
     case PositiveY:
-    {
-        float LowestYPosition{ 0.0f };
-        float LowestZPosition{ 0.0f };
-        float totalXPositions{ 0.0f };
-
-        for (const auto& vert : LocalVertices)
-        {
-            if (vert.Y < LowestYPosition)
-            {
-                LowestYPosition = vert.Y;
-            }
-            if (vert.Z < LowestZPosition)
-            {
-                LowestZPosition = vert.Z;
-            }
-            totalXPositions += vert.X;
-        }
-
-        rudderLocalLocation = FVector{ totalXPositions / LocalVertices.Num(),LowestYPosition,LowestZPosition };
+        rudderLocalLocation = FVector{ centroid.X, FMath::Min(bounds.Min.Y, 0.0), lowestZ };
         break;
-    }
     case NegativeY:
-    {
-        float HighestYPosition{ 0.0f };
-        float LowestZPosition{ 0.0f };
-        float totalXPositions{ 0.0f };
-
-        for (const auto& vert : LocalVertices)
-        {
-            if (vert.Y > HighestYPosition)
-            {
-                HighestYPosition = vert.Y;
-            }
-            if (vert.Z < LowestZPosition)
-            {
-                LowestZPosition = vert.Z;
-            }
-            totalXPositions += vert.X;
-        }
-        rudderLocalLocation = FVector{ totalXPositions / LocalVertices.Num(), HighestYPosition, LowestZPosition };
+        rudderLocalLocation = FVector{ centroid.X, FMath::Max(bounds.Max.Y, 0.0), lowestZ };
         break;
-    }
     default:
-    {
         break;
     }
-    }
     return rudderLocalLocation;
-}
+}
\ No newline at end of file
@@ -19,22 +19,20 @@ FVector BuoyancyProviderCore::ComputeForce(const PolyInfo* info, const IWaterSur
     constexpr float M_TO_UU = 100.0f;
     const float FluidDensity = 1025.0f;
     float area_m2 = info->Area * UU_TO_M * UU_TO_M;
-    FVector forceDir = ForceProviderHelpers::Core::CalculateForceDirectionOnPoly(*info);
-
-    if (FVector::DotProduct(forceDir, FVector::UpVector) < 0.0f)
+    const PolyFlow flow = ForceProviderHelpers::Core::GetPolyFlow(*info, waterSurface, hullMesh, world->GetTimeInSeconds());
+    if (flow.FacingAwayFromWater)
     {
         return FVector{};
     }
 
-    auto waterSample = waterSurface->SampleHeightAt(FVector2D{ info->gCentroid.X, info->gCentroid.Y }, world->GetTimeInSeconds());
-    float depth_uu = waterSample.Position.Z - info->gCentroid.Z;
+    float depth_uu = flow.Depth;
     if (depth_uu <= 0)
     {
         return FVector{};
     }
     float depth_m = FMath::Max(depth_uu * UU_TO_M, 0.0f);
     float volume_m3 = area_m2 * depth_m;
-    UE_LOG(LogTemp, Log, TEXT("Depth (cm) = %.1f"), depth_uu);
+    UE_LOG(LogTemp, Verbose, TEXT("Depth (cm) = %.1f"), depth_uu);
     float g_m_s2 = FMath::Abs(world->GetGravityZ()) * UU_TO_M;
     float buoyantMag = FluidDensity * g_m_s2 * volume_m3; //In Newtons but Unreal expects CentiNewtons
     buoyantMag *= M_TO_UU;
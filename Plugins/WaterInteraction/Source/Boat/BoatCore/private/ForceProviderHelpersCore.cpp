@@ -7,14 +7,19 @@ namespace ForceProviderHelpers::Core
 {
     FVector CalculateForceDirectionOnPoly(const PolyInfo& Poly)
     {
-        FVector v0 = Poly.gPointsContainer.Points[0];
-        FVector v1 = Poly.gPointsContainer.Points[1];
-        FVector v2 = Poly.gPointsContainer.Points[2];
-        FVector edge0 = v1 - v0;
-        FVector edge1 = v2 - v0;
+        // Filled when the polygon is built, precomputed for whole triangles
+        return Poly.gNormal;
+    }
 
-        FVector forceDir = (edge0 ^ edge1).GetSafeNormal();
-        return forceDir;
+    /// <summary>
+    /// The triangles that can never be wetted are removed when the hull is loaded, this is the part of the test that depends
+    /// on the attitude of the boat. All providers use it, so they agree on which polys they skip.
+    /// </summary>
+    /// <param name="Poly"></param>
+    /// <returns></returns>
+    bool IsFacingAwayFromWater(const PolyInfo& Poly)
+    {
+        return FVector::DotProduct(CalculateForceDirectionOnPoly(Poly), FVector::UpVector) < 0.0f;
     }
 
     FVector CalculatePolyVelocity(const PolyInfo& poly, const MeshAdaptor* hullMesh)
@@ -27,7 +32,7 @@ namespace ForceProviderHelpers::Core
             return FVector{};
         }
         FVector boatVelocity = hullMesh->GetVelocity() * UU_TO_M;
-        UE_LOG(LogTemp, Log, TEXT("Boat Velocity : %f"), boatVelocity.Size());
+        UE_LOG(LogTemp, Verbose, TEXT("Boat Velocity : %f"), boatVelocity.Size());
         //Get Boat Angular Velocity
         FVector boatAngularVelocity = hullMesh->GetAngularVelocity();
         //Get Boat Center of Gravity
@@ -56,9 +61,47 @@ namespace ForceProviderHelpers::Core
         FVector relativePolyVelocity = polyVelocity - waterVelocity; //the sign does not matter
         FVector tangentialFlowVector = relativePolyVelocity - (normal * FVector::DotProduct(relativePolyVelocity, normal));
         auto localPosition = hullMesh->GetComponentTransform().InverseTransformVector(polyInfo.gCentroid);
-        UE_LOG(LogTemp, Warning, TEXT("Water flow velocity : %f,%f,%f at Boat local position : %f,%f,%f"), tangentialFlowVector.X, tangentialFlowVector.Y, tangentialFlowVector.Z, localPosition.X, localPosition.Y, localPosition.Z);
+        UE_LOG(LogTemp, Verbose, TEXT("Water flow velocity : %f,%f,%f at Boat local position : %f,%f,%f"), tangentialFlowVector.X, tangentialFlowVector.Y, tangentialFlowVector.Z, localPosition.X, localPosition.Y, localPosition.Z);
         tangentialFlowVector = tangentialFlowVector.GetSafeNormal() * -1.0f * relativePolyVelocity.Size();
         
         return tangentialFlowVector;
     }
+    /// <summary>
+    /// Fused evaluation of one polygon: a single water sample at the centroid gives the depth, the hull motion gives the point
+    /// velocity, and the relative and tangential flow follow from them and the outward normal. The results match the separate
+    /// helpers above, which each provider used to call on its own.
+    /// </summary>
+    /// <param name="poly"></param>
+    /// <param name="waterSurface"></param>
+    /// <param name="hullMesh"></param>
+    /// <param name="time"></param>
+    /// <returns>Invalid when there is no water surface or hull</returns>
+    PolyFlow EvaluatePolyFlow(const PolyInfo& poly, const IWaterSurface* waterSurface, const MeshAdaptor* hullMesh, float time)
+    {
+        constexpr float UU_TO_M = 0.01f;
+        PolyFlow flow;
+        ensure(waterSurface != nullptr && hullMesh != nullptr);
+        if (waterSurface == nullptr || hullMesh == nullptr)
+        {
+            return flow;
+        }
+        flow.IsValid = true;
+        flow.FacingAwayFromWater = IsFacingAwayFromWater(poly);
+        flow.OutwardNormal = -1.0f * CalculateForceDirectionOnPoly(poly);
+
+        const FWaterSample waterSample = waterSurface->SampleHeightAt(FVector2D{ poly.gCentroid.X, poly.gCentroid.Y }, time);
+        flow.Depth = waterSample.IsValid ? waterSample.Position.Z - poly.gCentroid.Z : 0.0f;
+
+        const FVector cogToCentroid = (poly.gCentroid - hullMesh->GetCenterOfMass()) * UU_TO_M;
+        flow.PointVelocity = hullMesh->GetVelocity() * UU_TO_M + FVector::CrossProduct(hullMesh->GetAngularVelocity(), cogToCentroid);
+        flow.RelativeVelocity = flow.PointVelocity - waterSurface->GetWaterVelocity();
+        const FVector tangentialFlowVector = flow.RelativeVelocity - (flow.OutwardNormal * FVector::DotProduct(flow.RelativeVelocity, flow.OutwardNormal));
+        flow.TangentialFlow = tangentialFlowVector.GetSafeNormal() * -1.0f * flow.RelativeVelocity.Size();
+        return flow;
+    }
+
+    PolyFlow GetPolyFlow(const PolyInfo& poly, const IWaterSurface* waterSurface, const MeshAdaptor* hullMesh, float time)
+    {
+        return poly.Flow.IsValid ? poly.Flow : EvaluatePolyFlow(poly, waterSurface, hullMesh, time);
+    }
 }
\ No newline at end of file
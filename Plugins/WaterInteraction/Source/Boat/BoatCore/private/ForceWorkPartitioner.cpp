@@ -0,0 +1,51 @@
+#pragma once
+#include "ForceWorkPartitioner.h"
+#include "Async/TaskGraphInterfaces.h"
+
+/// <summary>
+/// Sizes the chunks to take about TargetChunkSeconds each at the measured cost, but small enough that every worker,
+/// the calling thread included, gets ChunksPerWorker of them, and never below MinChunkSize. Chunks are rounded up to whole
+/// reduction blocks so a block never spans two chunks.
+/// A hull that is cheaper than one chunk ends up as a single chunk and runs on the calling thread.
+/// </summary>
+/// <param name="numTriangles"></param>
+/// <returns></returns>
+int32 ForceWorkPartitioner::GetChunkSize(int32 numTriangles) const
+{
+    const int32 numWorkers = FTaskGraphInterface::IsRunning() ? FTaskGraphInterface::Get().GetNumWorkerThreads() + 1 : 1;
+    const int32 costChunkSize = FMath::Max(1, FMath::FloorToInt32(TargetChunkSeconds / FMath::Max(SecondsPerTriangle, UE_DOUBLE_SMALL_NUMBER)));
+    const int32 balancedChunkSize = FMath::DivideAndRoundUp(numTriangles, numWorkers * ChunksPerWorker);
+    const int32 chunkSize = FMath::Max(MinChunkSize, FMath::Min(costChunkSize, balancedChunkSize));
+    return FMath::DivideAndRoundUp(chunkSize, ReductionBlockSize) * ReductionBlockSize;
+}
+
+/// <summary>
+/// Exponential moving average of the busy time per triangle, dry clusters included, so the cost follows how much
+/// of the hull is in the water without jumping on a single slow tick.
+/// </summary>
+/// <param name="numTriangles"></param>
+/// <param name="busySeconds"></param>
+void ForceWorkPartitioner::RecordCost(int32 numTriangles, double busySeconds)
+{
+    if (numTriangles <= 0 || busySeconds <= 0.0)
+    {
+        return;
+    }
+    SecondsPerTriangle = FMath::Lerp(SecondsPerTriangle, busySeconds / numTriangles, CostSmoothing);
+}
+
+/// <summary>
+/// Sizes the partials buffer for the pass and clears it. It keeps its allocation between ticks, so only the first pass
+/// over a hull allocates.
+/// </summary>
+/// <param name="numTriangles"></param>
+/// <returns></returns>
+TArrayView<ForceWorkPartitioner::ForcePartial> ForceWorkPartitioner::ResetPartials(int32 numTriangles)
+{
+    Partials.SetNumUninitialized(FMath::DivideAndRoundUp(FMath::Max(numTriangles, 0), ReductionBlockSize), EAllowShrinking::No);
+    for (ForcePartial& partial : Partials)
+    {
+        partial = ForcePartial{};
+    }
+    return Partials;
+}
\ No newline at end of file
@@ -0,0 +1,652 @@
+#pragma once
+#include "HullData.h"
+#include "Async/ParallelFor.h"
+#include "Algo/Sort.h"
+
+namespace
+{
+    // Spreads the low 10 bits of value so there are two zero bits between each of them
+    uint32 SpreadBits3(uint32 value)
+    {
+        value &= 0x3ff;
+        value = (value | (value << 16)) & 0x030000ff;
+        value = (value | (value << 8)) & 0x0300f00f;
+        value = (value | (value << 4)) & 0x030c30c3;
+        value = (value | (value << 2)) & 0x09249249;
+        return value;
+    }
+
+    // Slab test, true when the ray starting at origin enters the box at any distance ahead
+    bool RayIntersectsBox(const FBox& box, const FVector& origin, const FVector& invDirection)
+    {
+        double nearDistance = 0.0;
+        double farDistance = UE_DOUBLE_BIG_NUMBER;
+        for (int32 axis = 0; axis < 3; ++axis)
+        {
+            double distance1 = (box.Min[axis] - origin[axis]) * invDirection[axis];
+            double distance2 = (box.Max[axis] - origin[axis]) * invDirection[axis];
+            if (distance1 > distance2)
+            {
+                Swap(distance1, distance2);
+            }
+            nearDistance = FMath::Max(nearDistance, distance1);
+            farDistance = FMath::Min(farDistance, distance2);
+            if (nearDistance > farDistance)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Two sided Moller-Trumbore, true when the ray hits the triangle further than minDistance from origin
+    bool RayIntersectsTriangle(const FVector& origin, const FVector& direction, const FVector& vertex1, const FVector& vertex2, const FVector& vertex3, double minDistance)
+    {
+        const FVector edge1 = vertex2 - vertex1;
+        const FVector edge2 = vertex3 - vertex1;
+        const FVector p = direction ^ edge2;
+        const double determinant = edge1 | p;
+        if (FMath::Abs(determinant) < UE_DOUBLE_SMALL_NUMBER)
+        {
+            return false;
+        }
+        const double invDeterminant = 1.0 / determinant;
+        const FVector s = origin - vertex1;
+        const double u = (s | p) * invDeterminant;
+        if (u < 0.0 || u > 1.0)
+        {
+            return false;
+        }
+        const FVector q = s ^ edge1;
+        const double v = (direction | q) * invDeterminant;
+        if (v < 0.0 || u + v > 1.0)
+        {
+            return false;
+        }
+        return (edge2 | q) * invDeterminant > minDistance;
+    }
+
+    // Sign that treats zero as positive, so the octahedron folds are never flattened onto an axis
+    double SignNotZero(double value)
+    {
+        return value >= 0.0 ? 1.0 : -1.0;
+    }
+
+    constexpr double QuantizedMax = 32767.0;
+}
+
+/// <summary>
+/// Turns the render mesh in Vertices, Indices and Normals into the physics hull. The bounds and centroid the rudder is placed from
+/// are taken after welding, before any triangle the water can't reach is removed.
+/// </summary>
+/// <param name="settings"></param>
+void HullData::Build(const HullBuildSettings& settings)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(HullData::Build);
+    Weld(settings);
+    MeshBounds = FBox(Vertices);
+    MeshCentroid = FVector::ZeroVector;
+    for (const FVector& vertex : Vertices)
+    {
+        MeshCentroid += vertex;
+    }
+    MeshCentroid /= FMath::Max(Vertices.Num(), 1);
+    BuildClusters(settings.TrianglesPerCluster);
+    RemoveNonWettedTriangles(settings);
+    CalcTriangleData();
+    if (settings.bQuantize)
+    {
+        Quantize(settings);
+    }
+}
+
+/// <summary>
+/// Welds the local vertices with a spatial hash of WeldTolerance sized cells, a vertex joins the first already welded vertex
+/// within the tolerance in its own or a neighbouring cell. The normals of the merged vertices are averaged.
+/// Triangles are remapped to the welded vertices, the ones that collapsed are removed and optionally the ones without area.
+/// </summary>
+/// <param name="settings"></param>
+void HullData::Weld(const HullBuildSettings& settings)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(HullData::Weld);
+    const float cellSize = FMath::Max(settings.WeldTolerance, KINDA_SMALL_NUMBER);
+    const float toleranceSquared = FMath::Square(FMath::Max(settings.WeldTolerance, 0.0f));
+    const bool hasNormals = Normals.Num() == Vertices.Num();
+    auto getCell = [cellSize](const FVector& position)
+        {
+            return FIntVector(FMath::FloorToInt32(position.X / cellSize), FMath::FloorToInt32(position.Y / cellSize), FMath::FloorToInt32(position.Z / cellSize));
+        };
+
+    TArray<FVector> weldedVertices;
+    TArray<FVector> weldedNormals;
+    TArray<int32> remap;
+    remap.SetNumUninitialized(Vertices.Num());
+    TMap<FIntVector, TArray<int32, TInlineAllocator<2>>> cells;
+    cells.Reserve(Vertices.Num());
+    for (int32 i = 0; i < Vertices.Num(); ++i)
+    {
+        const FVector& position = Vertices[i];
+        const FIntVector cell = getCell(position);
+        int32 welded = INDEX_NONE;
+        for (int32 z = -1; z <= 1 && welded == INDEX_NONE; ++z)
+        {
+            for (int32 y = -1; y <= 1 && welded == INDEX_NONE; ++y)
+            {
+                for (int32 x = -1; x <= 1 && welded == INDEX_NONE; ++x)
+                {
+                    if (const auto* candidates = cells.Find(cell + FIntVector(x, y, z)))
+                    {
+                        for (int32 candidate : *candidates)
+                        {
+                            if (FVector::DistSquared(weldedVertices[candidate], position) <= toleranceSquared)
+                            {
+                                welded = candidate;
+                                break;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        if (welded == INDEX_NONE)
+        {
+            welded = weldedVertices.Add(position);
+            weldedNormals.Add(FVector::ZeroVector);
+            cells.FindOrAdd(cell).Add(welded);
+        }
+        if (hasNormals)
+        {
+            weldedNormals[welded] += Normals[i];
+        }
+        remap[i] = welded;
+    }
+
+    TArray<uint32> weldedIndices;
+    weldedIndices.Reserve(Indices.Num());
+    int32 removedTriangles = 0;
+    for (int32 idx = 0; idx + 2 < Indices.Num(); idx += 3)
+    {
+        const int32 index1 = remap[Indices[idx]];
+        const int32 index2 = remap[Indices[idx + 1]];
+        const int32 index3 = remap[Indices[idx + 2]];
+        const bool isCollapsed = index1 == index2 || index1 == index3 || index2 == index3;
+        const bool hasNoArea = settings.bRemoveDegenerateTriangles &&
+            ((weldedVertices[index2] - weldedVertices[index1]) ^ (weldedVertices[index3] - weldedVertices[index1])).IsNearlyZero(UE_SMALL_NUMBER);
+        if (isCollapsed || hasNoArea)
+        {
+            ++removedTriangles;
+            continue;
+        }
+        weldedIndices.Add(index1);
+        weldedIndices.Add(index2);
+        weldedIndices.Add(index3);
+    }
+
+    UE_LOG(LogTemp, Log, TEXT("Hull welded from %d to %d vertices, %d degenerate triangles removed"), Vertices.Num(), weldedVertices.Num(), removedTriangles);
+    for (FVector& normal : weldedNormals)
+    {
+        normal = normal.GetSafeNormal();
+    }
+    Vertices = MoveTemp(weldedVertices);
+    Indices = MoveTemp(weldedIndices);
+    Normals = hasNormals ? MoveTemp(weldedNormals) : TArray<FVector>{};
+}
+
+/// <summary>
+/// Sorts the triangles by the Morton code of their centroid in the hull bounds, so triangles that are close on the hull
+/// are close in memory, and cuts the sorted list into clusters with their local bounds.
+/// The vertices are renumbered in the order the sorted triangles first use them, which keeps the per vertex passes local too.
+/// </summary>
+/// <param name="trianglesPerCluster"></param>
+void HullData::BuildClusters(int32 trianglesPerCluster)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(HullData::BuildClusters);
+    trianglesPerCluster = FMath::Max(trianglesPerCluster, 1);
+    const int32 numTriangles = Indices.Num() / 3;
+    Clusters.Reset();
+    if (numTriangles == 0)
+    {
+        return;
+    }
+
+    const FBox hullBounds(Vertices);
+    const FVector scale = FVector(1023.0) / hullBounds.GetSize().ComponentMax(FVector(UE_KINDA_SMALL_NUMBER));
+    TArray<TPair<uint32, int32>> mortonOrder;
+    mortonOrder.SetNumUninitialized(numTriangles);
+    for (int32 triangle = 0; triangle < numTriangles; ++triangle)
+    {
+        const FVector centroid = (Vertices[Indices[3 * triangle]] + Vertices[Indices[3 * triangle + 1]] + Vertices[Indices[3 * triangle + 2]]) / 3.0;
+        const FVector cell = (centroid - hullBounds.Min) * scale;
+        const uint32 code = SpreadBits3(static_cast<uint32>(cell.X)) | (SpreadBits3(static_cast<uint32>(cell.Y)) << 1) | (SpreadBits3(static_cast<uint32>(cell.Z)) << 2);
+        mortonOrder[triangle] = TPair<uint32, int32>(code, triangle);
+    }
+    // Ties keep the original order so the layout is the same on every run
+    Algo::Sort(mortonOrder, [](const TPair<uint32, int32>& a, const TPair<uint32, int32>& b) { return a.Key != b.Key ? a.Key < b.Key : a.Value < b.Value; });
+
+    TArray<int32> vertexRemap;
+    vertexRemap.Init(INDEX_NONE, Vertices.Num());
+    TArray<FVector> sortedVertices;
+    TArray<FVector> sortedNormals;
+    TArray<uint32> sortedIndices;
+    sortedVertices.Reserve(Vertices.Num());
+    sortedIndices.Reserve(Indices.Num());
+    const bool hasNormals = Normals.Num() == Vertices.Num();
+    for (const TPair<uint32, int32>& entry : mortonOrder)
+    {
+        for (int32 corner = 0; corner < 3; ++corner)
+        {
+            const uint32 oldIndex = Indices[3 * entry.Value + corner];
+            if (vertexRemap[oldIndex] == INDEX_NONE)
+            {
+                vertexRemap[oldIndex] = sortedVertices.Add(Vertices[oldIndex]);
+                if (hasNormals)
+                {
+                    sortedNormals.Add(Normals[oldIndex]);
+                }
+            }
+            sortedIndices.Add(vertexRemap[oldIndex]);
+        }
+    }
+    Vertices = MoveTemp(sortedVertices);
+    Normals = MoveTemp(sortedNormals);
+    Indices = MoveTemp(sortedIndices);
+
+    for (int32 first = 0; first < numTriangles; first += trianglesPerCluster)
+    {
+        HullCluster& cluster = Clusters.AddDefaulted_GetRef();
+        cluster.FirstTriangle = first;
+        cluster.NumTriangles = FMath::Min(trianglesPerCluster, numTriangles - first);
+        cluster.LocalBounds = FBox(ForceInit);
+        for (int32 idx = 3 * first; idx < 3 * (first + cluster.NumTriangles); ++idx)
+        {
+            cluster.LocalBounds += Vertices[Indices[idx]];
+        }
+    }
+}
+
+struct HullData::RayTreeNode
+{
+    FBox Bounds;
+    int32 FirstTriangle;
+    int32 NumTriangles; // Zero for inner nodes, whose left child directly follows them
+    int32 RightChild;
+};
+
+/// <summary>
+/// Builds the ray tree by halving the Morton ordered triangles until a run is small enough to be a leaf. Triangles that are close
+/// in the order are close on the hull, so the halves have tight bounds without sorting along any axis.
+/// </summary>
+/// <returns>Nodes in depth first order, the root first</returns>
+TArray<HullData::RayTreeNode> HullData::BuildRayTree() const
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(HullData::BuildRayTree);
+    constexpr int32 TrianglesPerLeaf = 8;
+    const int32 numTriangles = Indices.Num() / 3;
+    TArray<RayTreeNode> nodes;
+    if (numTriangles == 0)
+    {
+        return nodes;
+    }
+    nodes.Reserve(2 * FMath::DivideAndRoundUp(numTriangles, TrianglesPerLeaf));
+    auto buildNode = [&](auto& self, int32 firstTriangle, int32 numNodeTriangles) -> int32
+        {
+            const int32 nodeIndex = nodes.AddUninitialized();
+            if (numNodeTriangles <= TrianglesPerLeaf)
+            {
+                FBox bounds(ForceInit);
+                for (int32 idx = 3 * firstTriangle; idx < 3 * (firstTriangle + numNodeTriangles); ++idx)
+                {
+                    bounds += Vertices[Indices[idx]];
+                }
+                nodes[nodeIndex] = RayTreeNode{ bounds, firstTriangle, numNodeTriangles, INDEX_NONE };
+                return nodeIndex;
+            }
+            const int32 numLeftTriangles = numNodeTriangles / 2;
+            const int32 leftChild = self(self, firstTriangle, numLeftTriangles);
+            const int32 rightChild = self(self, firstTriangle + numLeftTriangles, numNodeTriangles - numLeftTriangles);
+            nodes[nodeIndex] = RayTreeNode{ nodes[leftChild].Bounds + nodes[rightChild].Bounds, firstTriangle, 0, rightChild };
+            return nodeIndex;
+        };
+    buildNode(buildNode, 0, numTriangles);
+    return nodes;
+}
+
+/// <summary>
+/// Casts a ray against the hull, walking the ray tree and skipping every subtree whose bounds the ray misses.
+/// </summary>
+/// <param name="rayTree">Built by BuildRayTree for the current triangles</param>
+/// <param name="origin"></param>
+/// <param name="direction">Normalized</param>
+/// <param name="ignoredTriangle">Triangle the ray starts on</param>
+/// <param name="minDistance">Hits closer than this are ignored</param>
+/// <returns>True when any other triangle is hit</returns>
+bool HullData::RayHitsHull(TArrayView<const RayTreeNode> rayTree, const FVector& origin, const FVector& direction, int32 ignoredTriangle, double minDistance) const
+{
+    auto safeInverse = [](double value) { return 1.0 / (FMath::Abs(value) > UE_DOUBLE_SMALL_NUMBER ? value : UE_DOUBLE_SMALL_NUMBER); };
+    const FVector invDirection(safeInverse(direction.X), safeInverse(direction.Y), safeInverse(direction.Z));
+    // The tree is balanced, its depth stays far below the inline size even for millions of triangles
+    TArray<int32, TInlineAllocator<64>> pendingNodes;
+    if (rayTree.Num() > 0)
+    {
+        pendingNodes.Push(0);
+    }
+    while (pendingNodes.Num() > 0)
+    {
+        const int32 nodeIndex = pendingNodes.Pop(EAllowShrinking::No);
+        const RayTreeNode& node = rayTree[nodeIndex];
+        if (!RayIntersectsBox(node.Bounds, origin, invDirection))
+        {
+            continue;
+        }
+        if (node.NumTriangles == 0)
+        {
+            pendingNodes.Push(node.RightChild);
+            pendingNodes.Push(nodeIndex + 1);
+            continue;
+        }
+        for (int32 triangle = node.FirstTriangle; triangle < node.FirstTriangle + node.NumTriangles; ++triangle)
+        {
+            if (triangle != ignoredTriangle && RayIntersectsTriangle(origin, direction, Vertices[Indices[3 * triangle]],
+                Vertices[Indices[3 * triangle + 1]], Vertices[Indices[3 * triangle + 2]], minDistance))
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/// <summary>
+/// Finds the triangles the water can never reach and removes them from the hull, so they never enter the per tick pipeline.
+/// A side of a triangle is open when any of five rays from its centroid, one along the normal of that side and four tilted 45 degrees
+/// away from it, leaves the hull without hitting another triangle. Triangles without an open side are enclosed, like cabin interiors
+/// or the inner skin of a thick hull. Triangles whose only open side faces up are decks.
+/// Both sides are tested, so the result doesn't depend on the winding of the mesh. The rays are cast against a ray tree over the
+/// Morton ordered triangles, so the triangles must already be clustered, and the clusters are rebuilt afterwards.
+/// </summary>
+/// <param name="settings"></param>
+void HullData::RemoveNonWettedTriangles(const HullBuildSettings& settings)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(HullData::RemoveNonWettedTriangles);
+    const int32 numTriangles = Indices.Num() / 3;
+    if (numTriangles == 0 || (!settings.bRemoveEnclosedTriangles && settings.DeckNormalMinZ > 1.0f))
+    {
+        return;
+    }
+    const double minDistance = 1e-4 * FBox(Vertices).GetSize().GetMax();
+    const TArray<RayTreeNode> rayTree = BuildRayTree();
+    TArray<bool> keepTriangle;
+    keepTriangle.SetNumUninitialized(numTriangles);
+    ParallelFor(numTriangles, [&](int32 triangle)
+        {
+            const FVector& vertex1 = Vertices[Indices[3 * triangle]];
+            const FVector& vertex2 = Vertices[Indices[3 * triangle + 1]];
+            const FVector& vertex3 = Vertices[Indices[3 * triangle + 2]];
+            const FVector normal = ((vertex2 - vertex1) ^ (vertex3 - vertex1)).GetSafeNormal();
+            keepTriangle[triangle] = true;
+            if (normal.IsZero())
+            {
+                return;
+            }
+            const FVector centroid = (vertex1 + vertex2 + vertex3) / 3.0;
+            FVector tangent1, tangent2;
+            normal.FindBestAxisVectors(tangent1, tangent2);
+            auto isSideOpen = [&](const FVector& sideNormal)
+                {
+                    const FVector directions[5] = { sideNormal, (sideNormal + tangent1).GetSafeNormal(), (sideNormal - tangent1).GetSafeNormal(),
+                        (sideNormal + tangent2).GetSafeNormal(), (sideNormal - tangent2).GetSafeNormal() };
+                    for (const FVector& direction : directions)
+                    {
+                        if (!RayHitsHull(rayTree, centroid, direction, triangle, minDistance))
+                        {
+                            return true;
+                        }
+                    }
+                    return false;
+                };
+            const bool isFrontOpen = isSideOpen(normal);
+            const bool isBackOpen = isSideOpen(-normal);
+            const bool isEnclosed = !isFrontOpen && !isBackOpen;
+            const bool isDeck = isFrontOpen != isBackOpen && (isFrontOpen ? normal.Z : -normal.Z) >= settings.DeckNormalMinZ;
+            keepTriangle[triangle] = !(settings.bRemoveEnclosedTriangles && isEnclosed) && !isDeck;
+        });
+
+    TArray<uint32> wettedIndices;
+    wettedIndices.Reserve(Indices.Num());
+    for (int32 triangle = 0; triangle < numTriangles; ++triangle)
+    {
+        if (keepTriangle[triangle])
+        {
+            wettedIndices.Append(&Indices[3 * triangle], 3);
+        }
+    }
+    UE_LOG(LogTemp, Log, TEXT("Hull reduced from %d to %d triangles that the water can reach"), numTriangles, wettedIndices.Num() / 3);
+    Indices = MoveTemp(wettedIndices);
+    // Also drops the vertices only the removed triangles used
+    BuildClusters(settings.TrianglesPerCluster);
+}
+
+/// <summary>
+/// Computes the normal and area of every triangle. They only change with the mesh,
+/// so the ticks rotate and scale them instead of taking a cross product and a square root per triangle.
+/// </summary>
+void HullData::CalcTriangleData()
+{
+    const int32 numTriangles = Indices.Num() / 3;
+    TriangleNormals.SetNumUninitialized(numTriangles);
+    TriangleAreas.SetNumUninitialized(numTriangles);
+    for (int32 triangle = 0; triangle < numTriangles; ++triangle)
+    {
+        const FVector& vertex1 = Vertices[Indices[3 * triangle]];
+        const FVector& vertex2 = Vertices[Indices[3 * triangle + 1]];
+        const FVector& vertex3 = Vertices[Indices[3 * triangle + 2]];
+        const FVector cross = (vertex2 - vertex1) ^ (vertex3 - vertex1);
+        TriangleNormals[triangle] = FVector3f(cross.GetSafeNormal());
+        TriangleAreas[triangle] = 0.5f * cross.Size();
+    }
+}
+
+/// <summary>
+/// Maps the vertices into the full int16 range over the bounds of the remaining hull, rounding to the nearest step.
+/// On big hulls a step can be longer than the weld tolerance, so distinct vertices may round to the same position. The vertices
+/// are snapped to their quantized positions first and the triangles that collapsed or lost their area are dropped, then the
+/// clusters and the triangle data are rebuilt from the snapped vertices, so they describe exactly what the ticks transform.
+/// The per vertex and per triangle normals are octahedral encoded.
+/// </summary>
+/// <param name="settings"></param>
+void HullData::Quantize(const HullBuildSettings& settings)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(HullData::Quantize);
+    if (Vertices.Num() == 0)
+    {
+        return;
+    }
+    const FBox bounds(Vertices);
+    QuantizationOffset = bounds.GetCenter();
+    const FVector extent = bounds.GetExtent();
+    for (int32 axis = 0; axis < 3; ++axis)
+    {
+        QuantizationScale[axis] = extent[axis] > UE_DOUBLE_SMALL_NUMBER ? extent[axis] / QuantizedMax : 1.0;
+    }
+    auto quantize = [this](const FVector& vertex)
+        {
+            const FVector steps = (vertex - QuantizationOffset) / QuantizationScale;
+            return QuantizedHullVertex{ static_cast<int16>(FMath::Clamp(FMath::RoundToInt32(steps.X), -32767, 32767)),
+                static_cast<int16>(FMath::Clamp(FMath::RoundToInt32(steps.Y), -32767, 32767)),
+                static_cast<int16>(FMath::Clamp(FMath::RoundToInt32(steps.Z), -32767, 32767)) };
+        };
+    for (FVector& vertex : Vertices)
+    {
+        const QuantizedHullVertex quantized = quantize(vertex);
+        vertex = FVector(quantized.X, quantized.Y, quantized.Z) * QuantizationScale + QuantizationOffset;
+    }
+
+    TArray<uint32> snappedIndices;
+    snappedIndices.Reserve(Indices.Num());
+    for (int32 idx = 0; idx + 2 < Indices.Num(); idx += 3)
+    {
+        const FVector& vertex1 = Vertices[Indices[idx]];
+        const FVector& vertex2 = Vertices[Indices[idx + 1]];
+        const FVector& vertex3 = Vertices[Indices[idx + 2]];
+        const bool isCollapsed = vertex1 == vertex2 || vertex1 == vertex3 || vertex2 == vertex3;
+        if (isCollapsed || ((vertex2 - vertex1) ^ (vertex3 - vertex1)).IsNearlyZero(UE_SMALL_NUMBER))
+        {
+            continue;
+        }
+        snappedIndices.Append({ Indices[idx], Indices[idx + 1], Indices[idx + 2] });
+    }
+    UE_LOG(LogTemp, Log, TEXT("Hull quantized, %d triangles collapsed"), (Indices.Num() - snappedIndices.Num()) / 3);
+    Indices = MoveTemp(snappedIndices);
+    BuildClusters(settings.TrianglesPerCluster);
+    CalcTriangleData();
+
+    QuantizedVertices.SetNumUninitialized(Vertices.Num());
+    for (int32 i = 0; i < Vertices.Num(); ++i)
+    {
+        QuantizedVertices[i] = quantize(Vertices[i]);
+    }
+    Vertices.Empty();
+    Normals.Empty();
+    DecodeTriangleNormals(EncodeTriangleNormals());
+}
+
+/// <summary>
+/// Octahedral encoding of TriangleNormals, the form a quantized hull saves them in.
+/// </summary>
+/// <returns></returns>
+TArray<uint32> HullData::EncodeTriangleNormals() const
+{
+    TArray<uint32> encodedNormals;
+    encodedNormals.SetNumUninitialized(TriangleNormals.Num());
+    for (int32 i = 0; i < TriangleNormals.Num(); ++i)
+    {
+        encodedNormals[i] = EncodeOctahedral(FVector(TriangleNormals[i]));
+    }
+    return encodedNormals;
+}
+
+/// <summary>
+/// Fills TriangleNormals from their octahedral encoding, so the ticks read plain normals. A hull that was just quantized goes
+/// through the encoding too, which gives it the normals it will have when it is loaded again.
+/// </summary>
+/// <param name="encodedNormals"></param>
+void HullData::DecodeTriangleNormals(TConstArrayView<uint32> encodedNormals)
+{
+    TriangleNormals.SetNumUninitialized(encodedNormals.Num());
+    for (int32 i = 0; i < encodedNormals.Num(); ++i)
+    {
+        TriangleNormals[i] = FVector3f(DecodeOctahedral(encodedNormals[i]));
+    }
+}
+
+/// <summary>
+/// Projects the normal onto the octahedron |x| + |y| + |z| = 1 and folds the lower half over the upper one,
+/// then stores x and y as 16 bit snorm. A zero normal, from a degenerate triangle, encodes as straight up.
+/// </summary>
+/// <param name="normal"></param>
+/// <returns></returns>
+uint32 HullData::EncodeOctahedral(const FVector& normal)
+{
+    const double sum = FMath::Abs(normal.X) + FMath::Abs(normal.Y) + FMath::Abs(normal.Z);
+    if (sum <= UE_DOUBLE_SMALL_NUMBER)
+    {
+        return 0;
+    }
+    double x = normal.X / sum;
+    double y = normal.Y / sum;
+    if (normal.Z < 0.0)
+    {
+        const double foldedX = (1.0 - FMath::Abs(y)) * SignNotZero(x);
+        const double foldedY = (1.0 - FMath::Abs(x)) * SignNotZero(y);
+        x = foldedX;
+        y = foldedY;
+    }
+    const uint16 encodedX = static_cast<uint16>(static_cast<int16>(FMath::RoundToInt32(FMath::Clamp(x, -1.0, 1.0) * QuantizedMax)));
+    const uint16 encodedY = static_cast<uint16>(static_cast<int16>(FMath::RoundToInt32(FMath::Clamp(y, -1.0, 1.0) * QuantizedMax)));
+    return static_cast<uint32>(encodedX) | (static_cast<uint32>(encodedY) << 16);
+}
+
+/// <summary>
+/// Inverse of EncodeOctahedral, the result is normalized again.
+/// </summary>
+/// <param name="encoded"></param>
+/// <returns></returns>
+FVector HullData::DecodeOctahedral(uint32 encoded)
+{
+    double x = static_cast<int16>(encoded & 0xffff) / QuantizedMax;
+    double y = static_cast<int16>(encoded >> 16) / QuantizedMax;
+    const double z = 1.0 - FMath::Abs(x) - FMath::Abs(y);
+    if (z < 0.0)
+    {
+        const double unfoldedX = (1.0 - FMath::Abs(y)) * SignNotZero(x);
+        const double unfoldedY = (1.0 - FMath::Abs(x)) * SignNotZero(y);
+        x = unfoldedX;
+        y = unfoldedY;
+    }
+    return FVector(x, y, z).GetSafeNormal();
+}
+
+/// <summary>
+/// Binary layout of the hull, the arrays are bulk serialized. Data written by a newer format is rejected,
+/// data from before version 2 has no quantized arrays and loads unquantized. Before version 3 the triangle normals were doubles
+/// and quantized hulls also saved per vertex normals, which are skipped. A quantized hull saves only the octahedral encoding
+/// of its triangle normals and decodes them once it is loaded.
+/// </summary>
+/// <param name="Ar"></param>
+/// <param name="hull"></param>
+/// <returns></returns>
+FArchive& operator<<(FArchive& Ar, HullData& hull)
+{
+    int32 version = HullData::SerializedVersion;
+    Ar << version;
+    if (Ar.IsLoading() && version > HullData::SerializedVersion)
+    {
+        UE_LOG(LogTemp, Error, TEXT("Hull data version %d is newer than the supported version %d"), version, HullData::SerializedVersion);
+        Ar.SetError();
+        return Ar;
+    }
+    Ar << hull.Vertices;
+    Ar << hull.Indices;
+    Ar << hull.Normals;
+    Ar << hull.Clusters;
+    if (version >= 3)
+    {
+        TArray<FVector3f> savedWithoutTriangleNormals;
+        Ar << (Ar.IsSaving() && hull.IsQuantized() ? savedWithoutTriangleNormals : hull.TriangleNormals);
+    }
+    else
+    {
+        TArray<FVector> oldTriangleNormals;
+        Ar << oldTriangleNormals;
+        hull.TriangleNormals.SetNumUninitialized(oldTriangleNormals.Num());
+        for (int32 i = 0; i < oldTriangleNormals.Num(); ++i)
+        {
+            hull.TriangleNormals[i] = FVector3f(oldTriangleNormals[i]);
+        }
+    }
+    Ar << hull.TriangleAreas;
+    Ar << hull.MeshBounds;
+    Ar << hull.MeshCentroid;
+    if (version >= 2)
+    {
+        Ar << hull.QuantizedVertices;
+        if (version == 2)
+        {
+            TArray<uint32> oldQuantizedNormals;
+            Ar << oldQuantizedNormals;
+        }
+        TArray<uint32> encodedTriangleNormals;
+        if (Ar.IsSaving() && hull.IsQuantized())
+        {
+            encodedTriangleNormals = hull.EncodeTriangleNormals();
+        }
+        Ar << encodedTriangleNormals;
+        Ar << hull.QuantizationScale;
+        Ar << hull.QuantizationOffset;
+        if (Ar.IsLoading() && hull.IsQuantized())
+        {
+            hull.DecodeTriangleNormals(encodedTriangleNormals);
+        }
+    }
+    return Ar;
+}
\ No newline at end of file
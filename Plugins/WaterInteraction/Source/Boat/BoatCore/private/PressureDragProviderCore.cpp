@@ -23,19 +23,16 @@ FVector PressureDragProviderCore::ComputeForce(const PolyInfo* info, const IWate
         return FVector{};
     }
     //Check dot product between relative point velocity and normal
-    auto normal = -1.0f * ForceProviderHelpers::Core::CalculateForceDirectionOnPoly(*info);
-    normal = normal.GetSafeNormal(); //Ensure normal is normalized
-    auto polyVelocity = ForceProviderHelpers::Core::CalculatePolyVelocity(*info, hullMesh); //in m/s
-    auto relativePolyVelocity = polyVelocity - waterSurface->GetWaterVelocity(); //in m/s
+    const PolyFlow flow = ForceProviderHelpers::Core::GetPolyFlow(*info, waterSurface, hullMesh, world->GetTimeInSeconds());
+    const FVector& normal = flow.OutwardNormal;
+    const FVector& relativePolyVelocity = flow.RelativeVelocity; //in m/s
     //skip interior triangles
-    if (FVector::DotProduct(normal, FVector::UpVector) >= 0.0f)
+    if (flow.FacingAwayFromWater)
     {
         return FVector{};
     }
 
-    auto waterSample = waterSurface->SampleHeightAt(FVector2D{ info->gCentroid.X, info->gCentroid.Y }, world->GetTimeInSeconds());
-
-    float depth_uu = waterSample.Position.Z - info->gCentroid.Z;
+    float depth_uu = flow.Depth;
     //If the poly is above water height then ignore
     if (depth_uu <= 0)
     {
@@ -50,17 +50,14 @@ FVector ViscoscityProviderCore::ComputeForce(const PolyInfo* info, const IWaterS
     }
 
     //Calculation of viscous force
-    FVector forceDir = ForceProviderHelpers::Core::CalculateForceDirectionOnPoly(*info); //This is the force applied on the poly
-
     //If it is an inside poly then ignore
-    if (FVector::DotProduct(forceDir, FVector::UpVector) < 0.0f)
+    const PolyFlow flow = ForceProviderHelpers::Core::GetPolyFlow(*info, waterSurface, hullMesh, world->GetTimeInSeconds());
+    if (flow.FacingAwayFromWater)
     {
         return FVector{};
     }
 
-    auto waterSample = waterSurface->SampleHeightAt(FVector2D{ info->gCentroid.X, info->gCentroid.Y },
-        world->GetTimeInSeconds());
-    float depth_uu = waterSample.Position.Z - info->gCentroid.Z;
+    float depth_uu = flow.Depth;
     //If the poly is above water height then ignore
     if (depth_uu <= 0)
     {
@@ -71,12 +68,11 @@ FVector ViscoscityProviderCore::ComputeForce(const PolyInfo* info, const IWaterS
     forceMagnitude *= info->Area * UU_TO_M * UU_TO_M;
     //Calculate Relative velocity of flow at this poly
 
-    FVector tangentialVelocity = ForceProviderHelpers::Core::CalculateRelativeVelocityOfFlowAtPolyCenter(*info,
-        waterSurface->GetWaterVelocity(), hullMesh);
+    FVector tangentialVelocity = flow.TangentialFlow;
 
     ensure(!tangentialVelocity.ContainsNaN());
     auto tangentialVelocitySize = tangentialVelocity.Size();
-    UE_LOG(LogTemp, Log, TEXT("TangentialVelocity : %f"), tangentialVelocitySize);
+    UE_LOG(LogTemp, Verbose, TEXT("TangentialVelocity : %f"), tangentialVelocitySize);
     forceMagnitude *= tangentialVelocitySize;
     FVector viscousForce = tangentialVelocity * forceMagnitude * (KFactor)*M_TO_UU; //KFactor is actually 1 + K because tha
     //if (context.DebugHUD->ShouldDrawViscoscityDebug)
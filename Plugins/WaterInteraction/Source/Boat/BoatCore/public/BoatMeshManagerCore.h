@@ -4,6 +4,7 @@
 #include "BoatRealTimeVertexProvider.h"
 #include "BoatRudder.h"
 #include "MeshAdaptor.h"
+#include "HullData.h"
 #include <functional>
 
 using GetBoatForwardDirectionCallback = std::function<uint8(void)>;
@@ -23,17 +24,21 @@ class BOATCORE_API BoatMeshManagerCore : public IBoatRealTimeVertexProvider, pub
     BoatMeshManagerCore() = default;
     virtual ~BoatMeshManagerCore() = default;
     
-    virtual void CalculateGlobalHullTriangles(TriangleInfoList& globalHullTriangles) const override;
+    virtual HullTrianglesView CalculateGlobalHullTriangles(const FTransform& hullTransform, const IWaterSurface* waterSurface, float time) override;
     virtual FVector GetRudderTransform() const override;
 protected:
-    TArray<FVector> LocalVertices;
-    TArray<uint32> LocalIndices;
-    TArray<FVector> LocalNormals;
+    TSharedPtr<const HullData> Hull; // Immutable once built, may be shared with other boats using the same mesh
 private:
     const TUniquePtr<MeshAdaptor> HullMesh;
     mutable TOptional<FVector> RudderLocation;
     GetBoatForwardDirectionCallback getBoatForwardDirection;
+    // World space results of CalculateGlobalHullTriangles, allocated on the first call and reused afterwards
+    TArray<FVector> WorldVertices;
+    TArray<float> VertexWaterHeights;
+    TArray<bool> VertexNeedsWater; // Set for the vertices of the clusters the water bounds could not cull
+    HullTriangleBuffer WorldTriangles;
     //void CalcLocalVerticesData();
+    void AllocateWorldBuffers();
     FVector CalcLocalRudderTransform() const;
 
 };
\ No newline at end of file
@@ -3,11 +3,13 @@
 #include "CoreMinimal.h"
 #include "PolyInfo.h"
 #include "MeshAdaptor.h"
+#include "WaterSurface.h"
 
 class IBoatRealTimeVertexProvider
 {
 public:
-    virtual void  CalculateGlobalHullTriangles(TriangleInfoList& globalHullTriangles) const = 0;
+    // Transforms the hull into world space with hullTransform and samples the water once at every vertex. The view stays valid until the next call.
+    virtual HullTrianglesView CalculateGlobalHullTriangles(const FTransform& hullTransform, const IWaterSurface* waterSurface, float time) = 0;
     virtual ~IBoatRealTimeVertexProvider() = default;
 protected:
     IBoatRealTimeVertexProvider() = default;
@@ -3,11 +3,18 @@
 #include "CoreMinimal.h"
 #include "PolyInfo.h"
 #include "WaterSample.h"
+#include "WaterSurface.h"
 #include "MeshAdaptor.h"
 
 namespace ForceProviderHelpers::Core
 {
 	FVector CalculateForceDirectionOnPoly(const PolyInfo& Poly);
+	// True when the force on the poly would point down, the side of the hull the water pushes on faces up
+	bool IsFacingAwayFromWater(const PolyInfo& Poly);
 	FVector CalculatePolyVelocity(const PolyInfo& poly, const MeshAdaptor* hullMesh);
 	FVector CalculateRelativeVelocityOfFlowAtPolyCenter(const PolyInfo& polyInfo, FVector waterVelocity, const MeshAdaptor* hullMesh);
+	// Samples the water once at the centroid and derives everything the providers need from it
+	PolyFlow EvaluatePolyFlow(const PolyInfo& poly, const IWaterSurface* waterSurface, const MeshAdaptor* hullMesh, float time);
+	// The flow stored in the poly when it was evaluated already, evaluated now otherwise
+	PolyFlow GetPolyFlow(const PolyInfo& poly, const IWaterSurface* waterSurface, const MeshAdaptor* hullMesh, float time);
 }
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "PolyInfo.h"
+
+// Splits the hull triangles into chunks for the force pass. The chunk size comes from the cost per triangle measured on the
+// previous ticks and the number of workers, so small hulls aren't spread over more chunks than pay for their scheduling and
+// big hulls still leave every worker several chunks to take from the others when its own run fast.
+// It also owns the per block partial sums and the per worker state of the pass, so hulls of any size on any number of
+// workers reuse the same buffers every tick.
+// Used from the game thread only.
+class BOATCORE_API ForceWorkPartitioner
+{
+public:
+    // Force and torque of one reduction block of triangles, summed in triangle order
+    struct ForcePartial
+    {
+        FVector Force = FVector::ZeroVector;
+        FVector Torque = FVector::ZeroVector;
+    };
+    // State of one worker that took part in the pass, never shared between threads
+    struct WorkerContext
+    {
+        double BusySeconds = 0.0;
+        PolyInfo Poly; // Reused by every triangle the worker clips, its points are inline
+    };
+
+    // Triangles per chunk for a pass over numTriangles, always a whole number of reduction blocks
+    int32 GetChunkSize(int32 numTriangles) const;
+    // Feeds back the time all workers together spent on a pass over numTriangles
+    void RecordCost(int32 numTriangles, double busySeconds);
+    double GetSecondsPerTriangle() const { return SecondsPerTriangle; }
+    // Zeroed partials, one per reduction block of a pass over numTriangles
+    TArrayView<ForcePartial> ResetPartials(int32 numTriangles);
+    // Handed to ParallelForWithTaskContext, which resets it without freeing, so it only allocates when more workers join
+    TArray<WorkerContext>& GetWorkerContexts() { return WorkerContexts; }
+
+    static constexpr double TargetChunkSeconds = 50e-6;     // Long enough to hide the cost of taking a chunk
+    static constexpr int32 ReductionBlockSize = 64;         // Fixed run of triangles summed into one partial, independent of the chunking
+    static constexpr int32 MinChunkSize = ReductionBlockSize;
+    static constexpr int32 ChunksPerWorker = 4;             // Left to balance uneven chunks
+    static constexpr double CostSmoothing = 0.2;            // Weight of the latest tick in the average
+private:
+    double SecondsPerTriangle = 0.5e-6;
+    TArray<ForcePartial> Partials; // Never shrinks, the hull rarely changes size
+    TArray<WorkerContext> WorkerContexts;
+};
\ No newline at end of file
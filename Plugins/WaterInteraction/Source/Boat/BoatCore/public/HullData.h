@@ -0,0 +1,88 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PolyInfo.h"
+
+// How the physics hull is derived from the render mesh when it is built
+struct HullBuildSettings
+{
+    float WeldTolerance = 0.1f;             // cm, vertices closer than this are merged into one
+    bool bRemoveDegenerateTriangles = true; // Drop triangles with no area, triangles whose corners were welded together are always dropped
+    int32 TrianglesPerCluster = 96;         // Size of the clusters the hull is classified against the water in
+    bool bRemoveEnclosedTriangles = true;   // Drop triangles closed in by the hull on both sides, like cabin interiors and inner shells
+    float DeckNormalMinZ = 0.9f;            // Drop triangles whose only open side faces at least this much up in local space, above 1 keeps the decks
+    bool bQuantize = false;                 // Store the built hull as 16 bit positions in its bounds and octahedral normals
+};
+
+// Hull vertex position in 16 bit fixed point, HullData::QuantizationScale and QuantizationOffset map it back to local space
+struct QuantizedHullVertex
+{
+    int16 X;
+    int16 Y;
+    int16 Z;
+};
+
+// The hull as the physics sees it: welded, clustered along a Morton curve and without the triangles the water can never reach.
+// It only depends on the mesh and the build settings, so it is built once, when the mesh is cooked or when the first boat spawns,
+// and never changes afterwards.
+struct BOATCORE_API HullData
+{
+    static constexpr int32 SerializedVersion = 3;
+
+    // Vertices, Indices and Normals hold the render mesh when this is called, every build step runs on them in order
+    void Build(const HullBuildSettings& settings);
+    bool IsEmpty() const { return Indices.Num() == 0; }
+    bool IsQuantized() const { return QuantizedVertices.Num() > 0; }
+    int32 NumVertices() const { return IsQuantized() ? QuantizedVertices.Num() : Vertices.Num(); }
+    // Two 16 bit snorm coordinates on the octahedron, X in the low half
+    static uint32 EncodeOctahedral(const FVector& normal);
+    static FVector DecodeOctahedral(uint32 encoded);
+    friend BOATCORE_API FArchive& operator<<(FArchive& Ar, HullData& hull);
+
+    TArray<FVector> Vertices;
+    TArray<uint32> Indices;
+    TArray<FVector> Normals;         // Per vertex, empty when the mesh had none
+    TArray<HullCluster> Clusters;    // Cover every triangle in order
+    TArray<FVector3f> TriangleNormals; // Unit normal and area of every triangle, rotated and scaled into world space instead of recomputed
+    TArray<float> TriangleAreas;
+    FBox MeshBounds = FBox(ForceInit);           // Of the welded mesh before any triangle was removed, the rudder is placed from them
+    FVector MeshCentroid = FVector::ZeroVector;
+
+    // Quantized hull, replaces Vertices and Normals, which are then empty. Its TriangleNormals are saved octahedral encoded
+    // and decoded when the hull is built or loaded
+    TArray<QuantizedHullVertex> QuantizedVertices;
+    FVector QuantizationScale = FVector::OneVector; // local = quantized * scale + offset
+    FVector QuantizationOffset = FVector::ZeroVector;
+private:
+    // Merges the render vertices that UV seams and hard edges split, so the physics only sees the real geometry
+    void Weld(const HullBuildSettings& settings);
+    // Orders the triangles along a Morton curve and splits them into clusters, the vertices follow in order of first use
+    void BuildClusters(int32 trianglesPerCluster);
+    // Drops the triangles the water can never reach, found by casting rays from both of their sides against the clustered hull
+    void RemoveNonWettedTriangles(const HullBuildSettings& settings);
+    void CalcTriangleData();
+    // Snaps the hull to the quantized positions, drops the triangles that collapsed and moves it into the quantized arrays
+    void Quantize(const HullBuildSettings& settings);
+    TArray<uint32> EncodeTriangleNormals() const;
+    void DecodeTriangleNormals(TConstArrayView<uint32> encodedNormals);
+    // Bounding volume hierarchy over small runs of the Morton ordered triangles, only lives while the triangles are classified
+    struct RayTreeNode;
+    TArray<RayTreeNode> BuildRayTree() const;
+    bool RayHitsHull(TArrayView<const RayTreeNode> rayTree, const FVector& origin, const FVector& direction, int32 ignoredTriangle, double minDistance) const;
+};
+
+inline FArchive& operator<<(FArchive& Ar, QuantizedHullVertex& vertex)
+{
+    Ar << vertex.X;
+    Ar << vertex.Y;
+    Ar << vertex.Z;
+    return Ar;
+}
+
+inline FArchive& operator<<(FArchive& Ar, HullCluster& cluster)
+{
+    Ar << cluster.FirstTriangle;
+    Ar << cluster.NumTriangles;
+    Ar << cluster.LocalBounds;
+    return Ar;
+}
\ No newline at end of file
@@ -0,0 +1,58 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "MeshAdaptor.h"
+#include "WorldAdaptor.h"
+
+// Rigid body state of the hull and the world, captured once per tick so the force providers never query the physics per polygon
+struct HullStateSnapshot
+{
+    FTransform ComponentTransform;
+    FVector Velocity = FVector::ZeroVector;        // cm/s
+    FVector AngularVelocity = FVector::ZeroVector; // rad/s
+    FVector CenterOfMass = FVector::ZeroVector;
+    FBoxSphereBounds Bounds;
+    float GravityZ = 0.0f;
+    float TimeInSeconds = 0.0f;
+
+    static HullStateSnapshot Capture(const MeshAdaptor& hullMesh, const WorldAdaptor& world)
+    {
+        HullStateSnapshot snapshot;
+        snapshot.ComponentTransform = hullMesh.GetComponentTransform();
+        snapshot.Velocity = hullMesh.GetVelocity();
+        snapshot.AngularVelocity = hullMesh.GetAngularVelocity();
+        snapshot.CenterOfMass = hullMesh.GetCenterOfMass();
+        snapshot.Bounds = hullMesh.GetBounds();
+        snapshot.GravityZ = world.GetGravityZ();
+        snapshot.TimeInSeconds = world.GetTimeInSeconds();
+        return snapshot;
+    }
+};
+
+// Adaptors that answer from a snapshot, for the code written against MeshAdaptor and WorldAdaptor
+class SnapshotMeshAdaptor : public MeshAdaptor
+{
+public:
+    SnapshotMeshAdaptor(const HullStateSnapshot& snapshot) : MeshAdaptor(), Snapshot(snapshot)
+    {
+    }
+    virtual FVector GetVelocity() const override { return Snapshot.Velocity; }
+    virtual FVector GetAngularVelocity() const override { return Snapshot.AngularVelocity; }
+    virtual FVector GetCenterOfMass() const override { return Snapshot.CenterOfMass; }
+    virtual FTransform GetComponentTransform() const override { return Snapshot.ComponentTransform; }
+    virtual FBoxSphereBounds GetBounds() const override { return Snapshot.Bounds; }
+private:
+    const HullStateSnapshot& Snapshot; // Does not own, lives for the tick
+};
+
+class SnapshotWorldAdaptor : public WorldAdaptor
+{
+public:
+    SnapshotWorldAdaptor(const HullStateSnapshot& snapshot) : WorldAdaptor(), Snapshot(snapshot)
+    {
+    }
+    virtual ~SnapshotWorldAdaptor() = default;
+    virtual float GetTimeInSeconds() const override { return Snapshot.TimeInSeconds; }
+    virtual float GetGravityZ() const override { return Snapshot.GravityZ; }
+private:
+    const HullStateSnapshot& Snapshot;
+};
\ No newline at end of file
@@ -4,15 +4,30 @@
 
 struct PolyPointsContainer
 {
-    TArray<FVector> Points;
-    FVector Normal;
+    // Clipping a triangle against the water leaves at most a quad, the points are stored inline so building a poly never allocates
+    static constexpr int32 MaxPoints = 4;
+    TArray<FVector, TFixedAllocator<MaxPoints>> Points;
+};
+
+// Water and hull motion at the centroid of a submerged polygon, evaluated once and read by every force provider
+struct PolyFlow
+{
+    bool IsValid = false;                        // Not evaluated yet, the providers evaluate it themselves
+    bool FacingAwayFromWater = false;            // The force on the poly would point down
+    float Depth = 0.0f;                          // cm of water above the centroid, not positive when it is dry or there is no water
+    FVector OutwardNormal = FVector::ZeroVector; // Unit normal pointing out of the hull into the water
+    FVector PointVelocity = FVector::ZeroVector; // m/s of the hull at the centroid
+    FVector RelativeVelocity = FVector::ZeroVector; // m/s, the point velocity minus the water velocity
+    FVector TangentialFlow = FVector::ZeroVector;   // m/s, flow of the water along the poly
 };
 
 struct PolyInfo
 {
     PolyPointsContainer gPointsContainer;
     FVector gCentroid;
+    FVector gNormal; // Unit normal from the winding of the points
     float Area;
+    PolyFlow Flow;
 };
 
 struct PolyInfoList
@@ -25,9 +40,76 @@ struct TriangleInfo
     FVector Vertex1;
     FVector Vertex2;
     FVector Vertex3;
+    // Height of the water surface above each vertex, the lowest float where there is no water
+    float WaterHeight1 = TNumericLimits<float>::Lowest();
+    float WaterHeight2 = TNumericLimits<float>::Lowest();
+    float WaterHeight3 = TNumericLimits<float>::Lowest();
+    // Unit normal from the winding and area of the whole triangle, derived from data precomputed for the local mesh
+    FVector Normal = FVector::ZeroVector;
+    float Area = 0.0f;
 };
 
 struct TriangleInfoList
 {
     TArray<TriangleInfo> Items;
+};
+
+// A spatially coherent run of hull triangles, built once when the hull is loaded
+struct HullCluster
+{
+    int32 FirstTriangle;
+    int32 NumTriangles;
+    FBox LocalBounds; // Bounds of the cluster's vertices in the space of the hull mesh
+};
+
+// Where a cluster is relative to the water this tick
+enum class EHullClusterState : uint8
+{
+    Dry,        // No triangle touches the water
+    Submerged,  // Every triangle is entirely under the water, no clipping needed
+    Straddling, // The waterline may cross the cluster, its triangles must be clipped
+};
+
+// World space hull triangles as parallel arrays, one slot per triangle in index buffer order.
+// Owned by the mesh manager, sized once and overwritten every tick.
+struct HullTriangleBuffer
+{
+    TArray<FVector> Vertex1;
+    TArray<FVector> Vertex2;
+    TArray<FVector> Vertex3;
+    TArray<float> WaterHeight1;
+    TArray<float> WaterHeight2;
+    TArray<float> WaterHeight3;
+    TArray<FVector> Normal; // Only filled for the triangles of clusters that are not dry
+    TArray<float> Area;
+    TArray<EHullClusterState> ClusterStates; // One per HullCluster
+
+    int32 Num() const { return Vertex1.Num(); }
+};
+
+// Read only view of a HullTriangleBuffer, valid until the next transform of the hull
+struct HullTrianglesView
+{
+    TArrayView<const FVector> Vertex1;
+    TArrayView<const FVector> Vertex2;
+    TArrayView<const FVector> Vertex3;
+    TArrayView<const float> WaterHeight1;
+    TArrayView<const float> WaterHeight2;
+    TArrayView<const float> WaterHeight3;
+    TArrayView<const FVector> Normal;
+    TArrayView<const float> Area;
+    TArrayView<const HullCluster> Clusters; // Cover every triangle in order
+    TArrayView<const EHullClusterState> ClusterStates;
+
+    HullTrianglesView() = default;
+    HullTrianglesView(const HullTriangleBuffer& buffer, TArrayView<const HullCluster> clusters) : Vertex1(buffer.Vertex1), Vertex2(buffer.Vertex2), Vertex3(buffer.Vertex3),
+        WaterHeight1(buffer.WaterHeight1), WaterHeight2(buffer.WaterHeight2), WaterHeight3(buffer.WaterHeight3),
+        Normal(buffer.Normal), Area(buffer.Area), Clusters(clusters), ClusterStates(buffer.ClusterStates)
+    {
+    }
+    int32 Num() const { return Vertex1.Num(); }
+    TriangleInfo operator[](int32 index) const
+    {
+        return TriangleInfo{ Vertex1[index], Vertex2[index], Vertex3[index], WaterHeight1[index], WaterHeight2[index], WaterHeight3[index], Normal[index], Area[index] };
+    }
 };
\ No newline at end of file
@@ -232,12 +232,19 @@ void ABoatPawn::BeginPlay()
     }
     if (WaterSurface == nullptr)
     {
-        WaterSurface = OceanActor->GerstnerWaveComponent;
+        WaterSurface = OceanActor->GetWaterSurface();
         check(WaterSurface != nullptr);
         BoatForceComponent->WaterSurface = WaterSurface;
     }
 
-    BoatRudder = MakeShared<BoatMeshManager>(HullMesh, [this]() {return static_cast<uint8>(this->EForwardAxis); });
+    HullBuildSettings hullBuildSettings;
+    hullBuildSettings.WeldTolerance = HullWeldTolerance;
+    hullBuildSettings.bRemoveDegenerateTriangles = bRemoveDegenerateHullTriangles;
+    hullBuildSettings.TrianglesPerCluster = TrianglesPerHullCluster;
+    hullBuildSettings.bRemoveEnclosedTriangles = bRemoveEnclosedHullTriangles;
+    hullBuildSettings.DeckNormalMinZ = HullDeckNormalMinZ;
+    hullBuildSettings.bQuantize = bQuantizeHull;
+    BoatRudder = MakeShared<BoatMeshManager>(HullMesh, [this]() {return static_cast<uint8>(this->EForwardAxis); }, hullBuildSettings);
     ensure(BoatRudder != nullptr);
     BoatForceComponent->BoatVertexProvider = StaticCastSharedPtr<BoatMeshManager>(BoatRudder);
     //Link the player controller with the Input Mapping Context - This is needed to be able to debug via visualizers or log tables
@@ -11,6 +11,9 @@
 #include "UObject/ScriptInterface.h"
 #include "IForceCommand.h"
 #include "Async/ParallelFor.h"
+#include "StaticMeshWrapper.h"
+#include "WorldWrapper.h"
+#include "HullStateSnapshot.h"
 
 UBoatForceComponent::UBoatForceComponent()
 {
@@ -46,13 +49,24 @@ void UBoatForceComponent::TickComponent(float DeltaTime, ELevelTick TickType, FA
     }
     ensure(BoatVertexProvider.IsValid());
    
-    TriangleInfoList globalHullTriangles;
-    BoatVertexProvider->CalculateGlobalHullTriangles(globalHullTriangles);
-    IForceContext forceContext{ &globalHullTriangles ,HullMesh,GetWorld(),WaterSurface,DebugHUD };
+    //The rigid body state is read from the physics once, every provider and polygon reads the snapshot
+    const HullStateSnapshot hullState = HullStateSnapshot::Capture(StaticMeshWrapper(HullMesh), WorldWrapper(GetWorld()));
+    const IWaterSurface* forceWaterSurface = WaterSurface;
+    if (bUseWaterHeightPatch)
+    {
+        //Evaluate the waves once over the hull footprint, the providers then only interpolate
+        const FBoxSphereBounds& hullBounds = hullState.Bounds;
+        const FVector2D center{ hullBounds.Origin.X, hullBounds.Origin.Y };
+        const FVector2D extent = FVector2D{ hullBounds.BoxExtent.X, hullBounds.BoxExtent.Y } + FVector2D{ WaterPatchPadding, WaterPatchPadding };
+        WaterPatch.Refresh(WaterSurface, FBox2D{ center - extent, center + extent }, WaterPatchResolution, hullState.TimeInSeconds);
+        forceWaterSurface = &WaterPatch;
+    }
+    const HullTrianglesView globalHullTriangles = BoatVertexProvider->CalculateGlobalHullTriangles(hullState.ComponentTransform, forceWaterSurface, hullState.TimeInSeconds);
+    IForceContext forceContext{ globalHullTriangles ,HullMesh,GetWorld(),forceWaterSurface,DebugHUD,&hullState };
     // ask each provider to append commands
-    ForceQueue.Empty();
+    ForceQueue.Reset(); // Keeps the capacity from the last tick
 
-    UForceProviderBase::ContributeForces(_Providers, forceContext, ForceQueue, BoatForceComponentMutex);
+    UForceProviderBase::ContributeForces(_Providers, forceContext, ForceQueue, ForcePartitioner);
 
     ParallelFor(ForceQueue.Num(), [&](int32_t idx) {ForceQueue[idx]->Execute(HullMesh); });
     //Debug draw the force commands
@@ -4,42 +4,60 @@
 #include "Engine/StaticMesh.h"
 #include "StaticMeshResources.h"
 #include "Components/StaticMeshComponent.h"
+#include "HullDataRegistry.h"
 
 /// <summary>
-/// This function calculates the local vertices, indices and normals of the boat hull mesh.
-/// It runs at the start of the simulation since the local vertex data is static.
+/// Takes the hull from the registry, which uses the hull cooked into the static mesh when there is one and otherwise
+/// shares one hull built from the render data between every boat with the same mesh and settings.
 /// </summary>
-void BoatMeshManager::CalcLocalVerticesData()
+/// <param name="hullMesh"></param>
+/// <param name="callBack"></param>
+/// <param name="buildSettings">Only used when the mesh has no cooked hull</param>
+BoatMeshManager::BoatMeshManager(const UStaticMeshComponent* hullMesh, GetBoatForwardDirectionCallback callBack, const HullBuildSettings& buildSettings) :
+    BoatMeshManagerCore(MakeUnique<StaticMeshWrapper>(hullMesh), callBack), HullMesh(hullMesh)
 {
-    ensure(HullMesh->GetStaticMesh() != nullptr);
-
-    if (HullMesh->GetStaticMesh() != nullptr)
+    const UStaticMesh* staticMesh = HullMesh->GetStaticMesh();
+    ensure(staticMesh != nullptr);
+    if (staticMesh == nullptr)
     {
-        const auto& LOD = HullMesh->GetStaticMesh()->GetRenderData()->LODResources[0];
-        const int numVerts = LOD.GetNumVertices();
+        UE_LOG(LogTemp, Error, TEXT("Boat does not have a static mesh"));
+        return;
+    }
+    Hull = HullDataRegistry::FindOrBuild(staticMesh, buildSettings);
+}
 
-        LocalVertices.SetNum(numVerts);
-        const auto& vertexPositionBuffer = LOD.VertexBuffers.PositionVertexBuffer;
-        for (int i = 0; i < LocalVertices.Num(); ++i)
-        {
-            LocalVertices[i] = (FVector)vertexPositionBuffer.VertexPosition(i);
-        }
+/// <summary>
+/// This function reads the local vertices, indices and normals of the boat hull mesh from its render data.
+/// </summary>
+/// <param name="staticMesh"></param>
+/// <param name="outHull"></param>
+/// <returns>False when the mesh has no render data</returns>
+bool BoatMeshManager::ReadRenderMesh(const UStaticMesh* staticMesh, HullData& outHull)
+{
+    if (staticMesh == nullptr || staticMesh->GetRenderData() == nullptr || staticMesh->GetRenderData()->LODResources.Num() == 0)
+    {
+        return false;
+    }
+    const auto& LOD = staticMesh->GetRenderData()->LODResources[0];
+    const int numVerts = LOD.GetNumVertices();
 
-        LocalIndices.SetNum(LOD.IndexBuffer.GetNumIndices());
+    outHull.Vertices.SetNum(numVerts);
+    const auto& vertexPositionBuffer = LOD.VertexBuffers.PositionVertexBuffer;
+    for (int i = 0; i < outHull.Vertices.Num(); ++i)
+    {
+        outHull.Vertices[i] = (FVector)vertexPositionBuffer.VertexPosition(i);
+    }
 
-        for (int i = 0; i < LocalIndices.Num(); ++i)
-        {
-            LocalIndices[i] = LOD.IndexBuffer.GetIndex(i);
-        }
-        LocalNormals.SetNum(numVerts);
-        const auto& smvb = LOD.VertexBuffers.StaticMeshVertexBuffer;
-        for (int i = 0; i < numVerts; ++i)
-        {
-            LocalNormals[i] = static_cast<FVector>(smvb.VertexTangentZ(i));
-        }
+    outHull.Indices.SetNum(LOD.IndexBuffer.GetNumIndices());
+    for (int i = 0; i < outHull.Indices.Num(); ++i)
+    {
+        outHull.Indices[i] = LOD.IndexBuffer.GetIndex(i);
     }
-    else
+    outHull.Normals.SetNum(numVerts);
+    const auto& smvb = LOD.VertexBuffers.StaticMeshVertexBuffer;
+    for (int i = 0; i < numVerts; ++i)
     {
-        UE_LOG(LogTemp, Error, TEXT("Boat does not have a static mesh"));
+        outHull.Normals[i] = static_cast<FVector>(smvb.VertexTangentZ(i));
     }
+    return true;
 }
\ No newline at end of file
@@ -5,8 +5,7 @@
 #include "Async/Fundamental/Task.h"
 #include "Tasks/Task.h"
 #include "BoatDebugHUD.h"
-#include "StaticMeshWrapper.h"
-#include "WorldWrapper.h"
+#include "HullStateSnapshot.h"
 
 /// <summary>
 /// This function computes the buoyant force on a polygon of the hull mesh.
@@ -17,8 +16,8 @@
 FVector UBuoyancyProvider::ComputeForce(const PolyInfo* Poly, IForceContext context) const
 {
     TRACE_CPUPROFILER_EVENT_SCOPE(UBuoyancyProvider::ComputeForce);
-    StaticMeshWrapper meshAdaptor(context.HullMesh);
-    WorldWrapper worldAdaptor(context.World);
+    SnapshotMeshAdaptor meshAdaptor(*context.HullState);
+    SnapshotWorldAdaptor worldAdaptor(*context.HullState);
     FVector effectiveBuoyantForce = BuoyancyProviderCore::ComputeForce(Poly, context.WaterSurface,&meshAdaptor,&worldAdaptor);
     return effectiveBuoyantForce;
 }
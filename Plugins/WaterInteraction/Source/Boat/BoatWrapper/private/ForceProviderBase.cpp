@@ -2,114 +2,139 @@
 #include "ForceProviderBase.h"
 #include "ForceCommands.h"
 #include "ForceProviderHelpers.h"
+#include "ForceProviderHelpersCore.h"
+#include "HullStateSnapshot.h"
 #include "Engine/World.h"
 #include "Async/ParallelFor.h"
+#include "Algo/BinarySearch.h"
 #include "Components/StaticMeshComponent.h"
 
+namespace
+{
+    using FForcePartial = ForceWorkPartitioner::ForcePartial;
+    using FWorkerContext = ForceWorkPartitioner::WorkerContext;
+
+    /// <summary>
+    /// Adds the partials up as a balanced tree in index order, neighbours first, then neighbouring pairs and so on.
+    /// The order only depends on the number of partials, so the same partials always give the same bits.
+    /// </summary>
+    /// <param name="partials">Overwritten with the intermediate sums</param>
+    /// <returns></returns>
+    FForcePartial PairwiseSum(TArrayView<FForcePartial> partials)
+    {
+        for (int32 stride = 1; stride < partials.Num(); stride *= 2)
+        {
+            for (int32 i = 0; i + stride < partials.Num(); i += 2 * stride)
+            {
+                partials[i].Force += partials[i + stride].Force;
+                partials[i].Torque += partials[i + stride].Torque;
+            }
+        }
+        return partials.Num() > 0 ? partials[0] : FForcePartial{};
+    }
+}
+
 /// <summary>
 /// Each provider provides a filtering process to get the polygon that is submerged in water.
 /// </summary>
 /// <param name="triangle"></param>
 /// <param name="outPoly"></param>
-/// <param name="waterSample"></param>
 /// <returns></returns>
-bool UForceProviderBase::GetFilteredPolygon(const TriangleInfo& triangle, PolyInfo& outPoly, const FWaterSample& waterSample) const
+bool UForceProviderBase::GetFilteredPolygon(const TriangleInfo& triangle, PolyInfo& outPoly) const
 {
     // Default implementation, can be overridden by derived classes
-    return ForceProviderHelpers::GetSubmergedPolygon(triangle, outPoly, waterSample);
+    return ForceProviderHelpers::GetSubmergedPolygon(triangle, outPoly);
 }
 
 /// <summary>
 /// Contribute forces from all force providers to the outQueue.
+/// Every submerged polygon is evaluated once, water depth, normal and flow included, and all providers read that record
+/// instead of sampling the water and the hull motion again.
+/// The triangles are split into chunks sized by the partitioner and the workers take chunks until none are left.
+/// The sums don't follow the chunks: every fixed block of ReductionBlockSize triangles is summed in triangle order into its own
+/// partial and the partials are added up pairwise in block order, all in double precision. The result is bit identical for the
+/// same hull and water whatever the chunk size, the number of workers or the order they finish in.
+/// The time spent on the chunks is fed back to the partitioner for the next tick.
 /// </summary>
 /// <param name="forceProviders"></param>
 /// <param name="context"></param>
 /// <param name="outQueue"></param>
-/// <param name="Mutex"></param>
-void UForceProviderBase::ContributeForces(TArray<UForceProviderBase*>& forceProviders, IForceContext context, TArray<FCommandPtr>& outQueue, FCriticalSection& Mutex)
+/// <param name="partitioner"></param>
+void UForceProviderBase::ContributeForces(TArray<UForceProviderBase*>& forceProviders, IForceContext context, TArray<FCommandPtr>& outQueue, ForceWorkPartitioner& partitioner)
 {
     TRACE_CPUPROFILER_EVENT_SCOPE(UForceProviderBase::ContributeForces);
-    check(context.HullMesh != nullptr);
-    if (context.HullMesh == nullptr)
+    check(context.HullMesh != nullptr && context.HullState != nullptr);
+    if (context.HullMesh == nullptr || context.HullState == nullptr)
     {
         return;
     }
-
-    FVector totalForce = FVector{}, totalTorque = FVector{};
-    ensure(context.HullTriangles != nullptr);
-    if (context.HullTriangles == nullptr)
+    const int32 numTriangles = context.HullTriangles.Num();
+    if (numTriangles == 0)
     {
         return;
     }
-    TArray<UE::Tasks::FTask> TaskHandles;
-
-    int NumBatches;
-    int BatchSize;
-    if (context.HullTriangles->Items.Num() <= 5000)
-    {
-        NumBatches = FPlatformMisc::NumberOfCores();
-        BatchSize = context.HullTriangles->Items.Num() / NumBatches;
-    }
-    else if (context.HullTriangles->Items.Num() > 5000 && context.HullTriangles->Items.Num() < 8000)
-    {
-        NumBatches = FPlatformMisc::NumberOfCores() * 2;
-        BatchSize = context.HullTriangles->Items.Num() / NumBatches;
-    }
-    else
-    {
-        NumBatches = FPlatformMisc::NumberOfCores() * 3;
-        BatchSize = context.HullTriangles->Items.Num() / NumBatches;
-    }
+    const HullStateSnapshot& hullState = *context.HullState;
+    const int32 chunkSize = partitioner.GetChunkSize(numTriangles);
+    const int32 numChunks = FMath::DivideAndRoundUp(numTriangles, chunkSize);
+    constexpr int32 BlockSize = ForceWorkPartitioner::ReductionBlockSize;
+    check(chunkSize % BlockSize == 0);
 
-    if (context.HullTriangles->Items.Num() % BatchSize != 0)
-    {
-        NumBatches += 1; // if there is a remainder, we need one more batch
-    }
-
-    for (int batchIndex = 0; batchIndex < NumBatches; ++batchIndex)
-    {
-        UE::Tasks::FTask task = UE::Tasks::Launch(UE_SOURCE_LOCATION, [&, batchIndex]
+    // Every block is written by the one chunk that contains it
+    const TArrayView<FForcePartial> partials = partitioner.ResetPartials(numTriangles);
+    TArray<FWorkerContext>& workerContexts = partitioner.GetWorkerContexts();
+    ParallelForWithTaskContext(TEXT("ContributeForces"), workerContexts, numChunks, [&](FWorkerContext& workerContext, int32 chunk)
+        {
+            const double chunkStartTime = FPlatformTime::Seconds();
+            SnapshotMeshAdaptor meshAdaptor(hullState);
+            PolyInfo& polyInfo = workerContext.Poly;
+            const int32 chunkStart = chunk * chunkSize;
+            const int32 chunkEnd = FMath::Min(chunkStart + chunkSize, numTriangles);
+            // The water heights at the vertices were sampled once for the whole hull when it was transformed,
+            // and every cluster was classified against them, so only the clusters on the waterline are clipped
+            const TArrayView<const HullCluster>& clusters = context.HullTriangles.Clusters;
+            int32 clusterIndex = Algo::UpperBoundBy(clusters, chunkStart, &HullCluster::FirstTriangle) - 1;
+            for (; clusterIndex < clusters.Num() && clusters[clusterIndex].FirstTriangle < chunkEnd; ++clusterIndex)
             {
-                FVector localTotalForce = FVector{}, localTotalTorque = FVector{};
-                for (int idx = 0; idx < BatchSize; ++idx)
+                const EHullClusterState state = context.HullTriangles.ClusterStates[clusterIndex];
+                if (state == EHullClusterState::Dry)
+                {
+                    continue;
+                }
+                const int32 clusterStart = FMath::Max(chunkStart, clusters[clusterIndex].FirstTriangle);
+                const int32 clusterEnd = FMath::Min(chunkEnd, clusters[clusterIndex].FirstTriangle + clusters[clusterIndex].NumTriangles);
+                for (int32 idx = clusterStart; idx < clusterEnd; ++idx)
                 {
-                    if (batchIndex * BatchSize + idx >= context.HullTriangles->Items.Num())
+                    const TriangleInfo triangle = context.HullTriangles[idx];
+                    // 1) filter only submerged:
+                    if (state == EHullClusterState::Submerged)
                     {
-                        break; // if we exceed the number of triangles, exit the loop
+                        ForceProviderHelpers::GetFullySubmergedPolygon(triangle, polyInfo);
                     }
-                    // Get the triangle at the current index in the batch
-                    auto& triangle = context.HullTriangles->Items[batchIndex * BatchSize + idx];
-                    PolyInfo polyInfo;
-                    // 1) filter only submerged:
-                    auto TriVertex1 = triangle.Vertex1;
-                    auto TriVertex2 = triangle.Vertex2;
-                    auto TriVertex3 = triangle.Vertex3;
-
-                    const FWaterSample waterSample = context.WaterSurface->SampleHeightAt(FVector2D{ (TriVertex1.X + TriVertex2.X + TriVertex3.X) / 3.0f,(TriVertex1.Y + TriVertex2.Y + TriVertex3.Y) / 3.0f }, context.World->TimeSeconds);
-
-                    if (!ForceProviderHelpers::GetSubmergedPolygon(triangle, polyInfo, waterSample))
+                    else if (!ForceProviderHelpers::GetSubmergedPolygon(triangle, polyInfo))
                     {
                         continue;
                     }
+                    // 2) sample the water and the hull motion once for every provider
+                    polyInfo.Flow = ForceProviderHelpers::Core::EvaluatePolyFlow(polyInfo, context.WaterSurface, &meshAdaptor, hullState.TimeInSeconds);
+                    FForcePartial& partial = partials[idx / BlockSize];
                     for (UForceProviderBase* provider : forceProviders)
                     {
                         FVector polyForce = provider->ComputeForce(&polyInfo, context);
-                        localTotalTorque += FVector::CrossProduct(polyInfo.gCentroid - context.HullMesh->GetCenterOfMass(), polyForce);
-                        localTotalForce += polyForce;
+                        partial.Torque += FVector::CrossProduct(polyInfo.gCentroid - hullState.CenterOfMass, polyForce);
+                        partial.Force += polyForce;
                     }
                 }
-                Mutex.Lock();
-                totalForce += localTotalForce;
-                totalTorque += localTotalTorque;
-                Mutex.Unlock();
-            });
-        TaskHandles.Add(task);
-    }
+            }
+            workerContext.BusySeconds += FPlatformTime::Seconds() - chunkStartTime;
+        });
 
-    UE::Tasks::FTask FinalTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, [&]()
-        {
-            outQueue.Add(MakeUnique<FAddForceAtLocationCommand>(totalForce, context.HullMesh->GetCenterOfMass()));
-            outQueue.Add(MakeUnique<FAddTorqueCommand>(totalTorque));
-        }, UE::Tasks::Prerequisites(TaskHandles)); // Wait for all tasks to complete
-    FinalTask.Wait(); // Wait for the final task to complete
+    double busySeconds = 0.0;
+    for (const FWorkerContext& workerContext : workerContexts)
+    {
+        busySeconds += workerContext.BusySeconds;
+    }
+    partitioner.RecordCost(numTriangles, busySeconds);
+    const FForcePartial total = PairwiseSum(partials);
+    outQueue.Add(MakeUnique<FAddForceAtLocationCommand>(total.Force, hullState.CenterOfMass));
+    outQueue.Add(MakeUnique<FAddTorqueCommand>(total.Torque));
 }
\ No newline at end of file
@@ -4,7 +4,7 @@
 namespace ForceProviderHelpers
 {
     /// <summary>
-    /// This function calculates the area and centroid for the poly.
+    /// This function calculates the area, centroid and normal for the poly.
     /// </summary>
     /// <param name="Poly"></param>
     void CalcPolyAreaAndCentroid(PolyInfo& Poly)
@@ -17,7 +17,7 @@ namespace ForceProviderHelpers
         {
             //Triangle
             area = CalcAreaOfTriangle(Poly.gPointsContainer.Points[0], Poly.gPointsContainer.Points[1], Poly.gPointsContainer.Points[2]);
-            centroid = CalcCentroid(TArray<FVector>{Poly.gPointsContainer.Points[0], Poly.gPointsContainer.Points[1], Poly.gPointsContainer.Points[2]});
+            centroid = CalcCentroid(Poly.gPointsContainer.Points);
         }
         else if (Poly.gPointsContainer.Points.Num() == 4)
         {
@@ -26,7 +26,7 @@ namespace ForceProviderHelpers
             float area1 = CalcAreaOfTriangle(Poly.gPointsContainer.Points[0], Poly.gPointsContainer.Points[1], Poly.gPointsContainer.Points[2]);
             float area2 = CalcAreaOfTriangle(Poly.gPointsContainer.Points[0], Poly.gPointsContainer.Points[2], Poly.gPointsContainer.Points[3]);
             area = area1 + area2;
-            centroid = CalcCentroid(TArray<FVector>{ Poly.gPointsContainer.Points[0], Poly.gPointsContainer.Points[1], Poly.gPointsContainer.Points[2], Poly.gPointsContainer.Points[3]});
+            centroid = CalcCentroid(Poly.gPointsContainer.Points);
         }
         else if (Poly.gPointsContainer.Points.Num() == 0)
         {
@@ -38,6 +38,7 @@ namespace ForceProviderHelpers
         }
         Poly.Area = area;
         Poly.gCentroid = centroid;
+        Poly.gNormal = ((Poly.gPointsContainer.Points[1] - Poly.gPointsContainer.Points[0]) ^ (Poly.gPointsContainer.Points[2] - Poly.gPointsContainer.Points[0])).GetSafeNormal();
     }
 
 
@@ -60,7 +61,7 @@ namespace ForceProviderHelpers
     /// </summary>
     /// <param name="vertices"></param>
     /// <returns></returns>
-    FVector CalcCentroid(const TArray<FVector>& vertices)
+    FVector CalcCentroid(TArrayView<const FVector> vertices)
     {
         FVector centroid = { 0,0,0 };
         for (int i = 0; i < vertices.Num(); ++i)
@@ -85,32 +86,26 @@ namespace ForceProviderHelpers
     /// <returns></returns>
     FVector CalculateForceDirectionOnPoly(const PolyInfo& Poly, bool ShouldDrawDebug, const UWorld* World)
     {
-        FVector v0 = Poly.gPointsContainer.Points[0];
-        FVector v1 = Poly.gPointsContainer.Points[1];
-        FVector v2 = Poly.gPointsContainer.Points[2];
-        FVector edge0 = v1 - v0;
-        FVector edge1 = v2 - v0;
-
-        FVector forceDir = (edge0 ^ edge1).GetSafeNormal();
-
-        return forceDir;
+        // Filled when the polygon is built, precomputed for whole triangles
+        return Poly.gNormal;
     }
     /// <summary>
-    ///  This function finds the interpolation point between two vertices of a triangle at the water sample height.
+    ///  This function finds the point on the edge between two vertices of a triangle where the water crosses it.
+    ///  The depth below the water is linear along the edge, so the crossing is where it reaches zero.
     /// </summary>
-    /// <param name="vertex2"></param>
-    /// <param name="vertex1"></param>
-    /// <param name="waterSample"></param>
+    /// <param name="vertex2">Vertex above the water</param>
+    /// <param name="vertex1">Vertex below the water</param>
+    /// <param name="depth2">Depth of vertex2 below the water, not positive</param>
+    /// <param name="depth1">Depth of vertex1 below the water, positive</param>
     /// <returns></returns>
-    FVector FindInterpPoint(FVector& vertex2, FVector& vertex1, const FWaterSample& waterSample)
+    FVector FindInterpPoint(const FVector& vertex2, const FVector& vertex1, float depth2, float depth1)
     {
         FVector localLine = vertex2 - vertex1;
 
-        float dz = vertex2.Z - vertex1.Z;
-        check(dz > 0.0f);
-        float t = waterSample.Position.Z - vertex1.Z;
-        check(t > 0.0f);
-        float ratio = t / dz;
+        float dDepth = depth1 - depth2;
+        check(dDepth > 0.0f);
+        check(depth1 > 0.0f);
+        float ratio = depth1 / dDepth;
         FVector midPoint = vertex1 + ratio * localLine;
         return midPoint;
     }
@@ -119,20 +114,23 @@ namespace ForceProviderHelpers
     /// </summary>
     /// <param name="outPointsContainer"></param>
     /// <param name="vertex1"></param>
+    /// <param name="depth1"></param>
     /// <param name="isVertex2Submerged"></param>
     /// <param name="vertex2"></param>
+    /// <param name="depth2"></param>
     /// <param name="vertex3"></param>
-    /// <param name="waterSample"></param>
+    /// <param name="depth3"></param>
     /// <param name="isVertex3Submerged"></param>
-    void ComputeComplexPolygon(PolyPointsContainer& outPointsContainer, FVector vertex1, bool isVertex2Submerged, FVector vertex2, FVector vertex3, const FWaterSample& waterSample, bool isVertex3Submerged)
+    void ComputeComplexPolygon(PolyPointsContainer& outPointsContainer, FVector vertex1, float depth1, bool isVertex2Submerged, FVector vertex2, float depth2,
+        FVector vertex3, float depth3, bool isVertex3Submerged)
     {
         outPointsContainer.Points.Push(vertex1);
         if (isVertex2Submerged)
         {
             outPointsContainer.Points.Push(vertex2);
             //interpolate between 1,3 and 2,3 at the water z
-            FVector interpPoint23 = FindInterpPoint(vertex3, vertex2, waterSample);
-            FVector interpPoint13 = FindInterpPoint(vertex3, vertex1, waterSample);
+            FVector interpPoint23 = FindInterpPoint(vertex3, vertex2, depth3, depth2);
+            FVector interpPoint13 = FindInterpPoint(vertex3, vertex1, depth3, depth1);
             outPointsContainer.Points.Push(interpPoint23);
             outPointsContainer.Points.Push(interpPoint13);
         }
@@ -140,16 +138,16 @@ namespace ForceProviderHelpers
         {
             outPointsContainer.Points.Push(vertex3);
             //interpolate between 1,2 and 3,2 at the water z
-            FVector interpPoint12 = FindInterpPoint(vertex2, vertex1, waterSample);
-            FVector interpPoint32 = FindInterpPoint(vertex2, vertex3, waterSample);
+            FVector interpPoint12 = FindInterpPoint(vertex2, vertex1, depth2, depth1);
+            FVector interpPoint32 = FindInterpPoint(vertex2, vertex3, depth2, depth3);
             outPointsContainer.Points.Push(interpPoint12);
             outPointsContainer.Points.Push(interpPoint32);
         }
         else //only vertex1 is submerged
         {
             //interpolate between 1,2 and 1,3 at the water z
-            FVector interpPoint12 = FindInterpPoint(vertex2, vertex1, waterSample);
-            FVector interpPoint13 = FindInterpPoint(vertex3, vertex1, waterSample);
+            FVector interpPoint12 = FindInterpPoint(vertex2, vertex1, depth2, depth1);
+            FVector interpPoint13 = FindInterpPoint(vertex3, vertex1, depth3, depth1);
             outPointsContainer.Points.Push(interpPoint12);
             outPointsContainer.Points.Push(interpPoint13);
         }
@@ -157,35 +155,25 @@ namespace ForceProviderHelpers
 
 /// <summary>
 /// This function finds if a triangle is completely, partially or not at all submerged in the water.
+/// Every vertex is compared against the water height sampled at that vertex.
 /// </summary>
-/// <param name="vertex1"></param>
-/// <param name="vertex2"></param>
-/// <param name="vertex3"></param>
+/// <param name="triangle"></param>
 /// <param name="outPointsContainer"></param>
-/// <param name="waterSample"></param>
-    void ClipTriangleAgainstWater(FVector vertex1, FVector vertex2, FVector vertex3, PolyPointsContainer& outPointsContainer, const FWaterSample& waterSample)
+    void ClipTriangleAgainstWater(const TriangleInfo& triangle, PolyPointsContainer& outPointsContainer)
     {
         TRACE_CPUPROFILER_EVENT_SCOPE(ABoatPawn::ClipTriangleAgainstWater);
+        const FVector& vertex1 = triangle.Vertex1;
+        const FVector& vertex2 = triangle.Vertex2;
+        const FVector& vertex3 = triangle.Vertex3;
         check(vertex1 != vertex2 && vertex1 != vertex3 && vertex1 != vertex3);
-        bool isVertex1Submerged = false;
-        bool isVertex2Submerged = false;
-        bool isVertex3Submerged = false;
-        //This is an approximation since water sample has been taken at centroid
-        outPointsContainer.Normal = waterSample.Normal;
+        const float depth1 = triangle.WaterHeight1 - vertex1.Z;
+        const float depth2 = triangle.WaterHeight2 - vertex2.Z;
+        const float depth3 = triangle.WaterHeight3 - vertex3.Z;
+        bool isVertex1Submerged = depth1 > 0.0f;
+        bool isVertex2Submerged = depth2 > 0.0f;
+        bool isVertex3Submerged = depth3 > 0.0f;
         outPointsContainer.Points.Empty();
 
-        if (vertex1.Z < waterSample.Position.Z)
-        {
-            isVertex1Submerged = true;
-        }
-        if (vertex2.Z < waterSample.Position.Z)
-        {
-            isVertex2Submerged = true;
-        }
-        if (vertex3.Z < waterSample.Position.Z)
-        {
-            isVertex3Submerged = true;
-        }
         if (isVertex1Submerged && isVertex2Submerged && isVertex3Submerged)
         {
             outPointsContainer.Points.Push(vertex1);
@@ -204,17 +192,17 @@ namespace ForceProviderHelpers
             //Check if 1 or 2 vertices are submerged
             if (isVertex1Submerged)
             {
-                ComputeComplexPolygon(outPointsContainer, vertex1, isVertex2Submerged, vertex2, vertex3, waterSample, isVertex3Submerged);
+                ComputeComplexPolygon(outPointsContainer, vertex1, depth1, isVertex2Submerged, vertex2, depth2, vertex3, depth3, isVertex3Submerged);
                 return;
             }
             else if (isVertex2Submerged)
             {
-                ComputeComplexPolygon(outPointsContainer, vertex2, isVertex1Submerged, vertex1, vertex3, waterSample, isVertex3Submerged);
+                ComputeComplexPolygon(outPointsContainer, vertex2, depth2, isVertex1Submerged, vertex1, depth1, vertex3, depth3, isVertex3Submerged);
                 return;
             }
             else if (isVertex3Submerged)
             {
-                ComputeComplexPolygon(outPointsContainer, vertex3, isVertex1Submerged, vertex1, vertex2, waterSample, isVertex2Submerged);
+                ComputeComplexPolygon(outPointsContainer, vertex3, depth3, isVertex1Submerged, vertex1, depth1, vertex2, depth2, isVertex2Submerged);
                 return;
             }
             return;
@@ -222,27 +210,22 @@ namespace ForceProviderHelpers
     }
 
     /// <summary>
-    /// This function finds the submerged polygon from a triangle and water sample. It checks if the triangle is fully, or partially submerged in the water and returns the polygon formed by the submerged vertices.
+    /// This function finds the submerged polygon from a triangle and the water heights at its vertices. It checks if the triangle is fully, or partially submerged in the water and returns the polygon formed by the submerged vertices.
     /// </summary>
     /// <param name="triangle"></param>
     /// <param name="outPoly"></param>
-    /// <param name="waterSample"></param>
     /// <returns></returns>
-    bool GetSubmergedPolygon(const TriangleInfo& triangle, PolyInfo& outPoly, const FWaterSample& waterSample)
+    bool GetSubmergedPolygon(const TriangleInfo& triangle, PolyInfo& outPoly)
     {
-        auto TriVertex1 = triangle.Vertex1;
-        auto TriVertex2 = triangle.Vertex2;
-        auto TriVertex3 = triangle.Vertex3;
-
-        outPoly.gPointsContainer.Points.Reset();
-        //Maybe check if water is there
-        //Check if centroid of boat x,y exists on the water
-        if (waterSample.IsValid == false)
+        if (triangle.WaterHeight1 > triangle.Vertex1.Z && triangle.WaterHeight2 > triangle.Vertex2.Z && triangle.WaterHeight3 > triangle.Vertex3.Z)
         {
-            return false;
+            //Whole triangles keep the precomputed geometry, only the clipped ones need fresh geometry
+            GetFullySubmergedPolygon(triangle, outPoly);
+            return true;
         }
-
-        ForceProviderHelpers::ClipTriangleAgainstWater(TriVertex1, TriVertex2, TriVertex3, outPoly.gPointsContainer, waterSample);
+        outPoly.gPointsContainer.Points.Reset();
+        //Vertices without water have the lowest height, so they are never submerged
+        ForceProviderHelpers::ClipTriangleAgainstWater(triangle, outPoly.gPointsContainer);
         ////It must have a polygon, calc area and centroid
         if (outPoly.gPointsContainer.Points.Num() == 0)
         {
@@ -253,6 +236,22 @@ namespace ForceProviderHelpers
         return true;
     }
     /// <summary>
+    /// This function builds the polygon of a triangle that is known to be entirely under the water, without testing its vertices.
+    /// The normal and area come with the triangle, so only the centroid is computed.
+    /// </summary>
+    /// <param name="triangle"></param>
+    /// <param name="outPoly"></param>
+    void GetFullySubmergedPolygon(const TriangleInfo& triangle, PolyInfo& outPoly)
+    {
+        outPoly.gPointsContainer.Points.Reset();
+        outPoly.gPointsContainer.Points.Push(triangle.Vertex1);
+        outPoly.gPointsContainer.Points.Push(triangle.Vertex2);
+        outPoly.gPointsContainer.Points.Push(triangle.Vertex3);
+        outPoly.gCentroid = (triangle.Vertex1 + triangle.Vertex2 + triangle.Vertex3) / 3.0;
+        outPoly.gNormal = triangle.Normal;
+        outPoly.Area = triangle.Area;
+    }
+    /// <summary>
     /// This function calculates the relative velocity of the water flow at the center of the polygon. 
     /// The direction of the flow is tangential to the surface of the water at the polygon's center.
     /// </summary>
@@ -282,7 +281,7 @@ namespace ForceProviderHelpers
 
         FVector tangentialFlowVector = relativePolyVelocity - (normal * FVector::DotProduct(relativePolyVelocity, normal));
         auto localPosition = hullMesh->GetComponentTransform().InverseTransformVector(polyInfo.gCentroid);
-        UE_LOG(LogTemp, Warning, TEXT("Water flow velocity : %f,%f,%f at Boat local position : %f,%f,%f"), tangentialFlowVector.X, tangentialFlowVector.Y, tangentialFlowVector.Z, localPosition.X, localPosition.Y, localPosition.Z);
+        UE_LOG(LogTemp, Verbose, TEXT("Water flow velocity : %f,%f,%f at Boat local position : %f,%f,%f"), tangentialFlowVector.X, tangentialFlowVector.Y, tangentialFlowVector.Z, localPosition.X, localPosition.Y, localPosition.Z);
         tangentialFlowVector = tangentialFlowVector.GetSafeNormal() * -1.0f * relativePolyVelocity.Size();
         if (shouldDrawDebug == true)
         {
@@ -307,7 +306,7 @@ namespace ForceProviderHelpers
             return FVector{};
         }
         FVector boatVelocity = hullMesh->GetComponentVelocity() * UU_TO_M;
-        UE_LOG(LogTemp, Log, TEXT("Boat Velocity : %f"), boatVelocity.Size());
+        UE_LOG(LogTemp, Verbose, TEXT("Boat Velocity : %f"), boatVelocity.Size());
         //Get Boat Angular Velocity
         FVector boatAngularVelocity = hullMesh->GetPhysicsAngularVelocityInRadians();
         //Get Boat Center of Gravity
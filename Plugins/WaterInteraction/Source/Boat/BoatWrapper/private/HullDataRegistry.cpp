@@ -0,0 +1,81 @@
+#pragma once
+#include "HullDataRegistry.h"
+#include "BoatMeshManager.h"
+#include "Engine/StaticMesh.h"
+#include "HullPhysicsAssetUserData.h"
+
+FCriticalSection HullDataRegistry::RegistryMutex;
+TMap<TObjectKey<UStaticMesh>, TArray<HullDataRegistry::Entry, TInlineAllocator<1>>> HullDataRegistry::Entries;
+
+namespace
+{
+    bool HaveSameSettings(const HullBuildSettings& a, const HullBuildSettings& b)
+    {
+        return a.WeldTolerance == b.WeldTolerance && a.bRemoveDegenerateTriangles == b.bRemoveDegenerateTriangles && a.TrianglesPerCluster == b.TrianglesPerCluster &&
+            a.bRemoveEnclosedTriangles == b.bRemoveEnclosedTriangles && a.DeckNormalMinZ == b.DeckNormalMinZ && a.bQuantize == b.bQuantize;
+    }
+}
+
+/// <summary>
+/// Looks the mesh and settings up and builds the hull only when no live boat holds one already.
+/// Entries whose hull was freed are dropped on the way, and so are the meshes left without any. The build runs under the lock,
+/// so two boats spawning together with the same mesh never build it twice. A hull that couldn't be built isn't registered,
+/// the next boat tries again.
+/// </summary>
+/// <param name="staticMesh"></param>
+/// <param name="settings">Ignored for meshes with a cooked hull</param>
+/// <returns>Null when the mesh is null or its render data gave no hull</returns>
+TSharedPtr<const HullData> HullDataRegistry::FindOrBuild(const UStaticMesh* staticMesh, const HullBuildSettings& settings)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(HullDataRegistry::FindOrBuild);
+    if (staticMesh == nullptr)
+    {
+        return nullptr;
+    }
+    if (const UHullPhysicsAssetUserData* cookedHull = const_cast<UStaticMesh*>(staticMesh)->GetAssetUserData<UHullPhysicsAssetUserData>())
+    {
+        if (TSharedPtr<const HullData> hull = cookedHull->GetHullData())
+        {
+            return hull;
+        }
+    }
+
+    FScopeLock lock(&RegistryMutex);
+    // Boats spawn rarely, sweeping every mesh keeps the map as small as the set of meshes in use
+    for (auto it = Entries.CreateIterator(); it; ++it)
+    {
+        it->Value.RemoveAllSwap([](const Entry& entry) { return !entry.Hull.IsValid(); });
+        if (it->Value.Num() == 0)
+        {
+            it.RemoveCurrent();
+        }
+    }
+    const TObjectKey<UStaticMesh> meshKey(staticMesh);
+    if (const auto* meshEntries = Entries.Find(meshKey))
+    {
+        for (const Entry& entry : *meshEntries)
+        {
+            if (HaveSameSettings(entry.Settings, settings))
+            {
+                if (TSharedPtr<const HullData> hull = entry.Hull.Pin())
+                {
+                    return hull;
+                }
+            }
+        }
+    }
+
+    TSharedPtr<HullData> builtHull = MakeShared<HullData>();
+    if (!BoatMeshManager::ReadRenderMesh(staticMesh, *builtHull))
+    {
+        return nullptr;
+    }
+    builtHull->Build(settings);
+    if (builtHull->IsEmpty())
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Hull of %s has no triangles the water can reach"), *staticMesh->GetName());
+        return nullptr;
+    }
+    Entries.FindOrAdd(meshKey).Add(Entry{ settings, builtHull });
+    return builtHull;
+}
\ No newline at end of file
@@ -0,0 +1,67 @@
+#pragma once
+#include "HullPhysicsAssetUserData.h"
+#include "BoatMeshManager.h"
+#include "Engine/StaticMesh.h"
+#include "UObject/ObjectSaveContext.h"
+
+TSharedPtr<const HullData> UHullPhysicsAssetUserData::GetHullData() const
+{
+    return Hull.IsValid() && !Hull->IsEmpty() ? Hull : nullptr;
+}
+
+HullBuildSettings UHullPhysicsAssetUserData::GetBuildSettings() const
+{
+    HullBuildSettings settings;
+    settings.WeldTolerance = WeldTolerance;
+    settings.bRemoveDegenerateTriangles = bRemoveDegenerateTriangles;
+    settings.TrianglesPerCluster = TrianglesPerCluster;
+    settings.bRemoveEnclosedTriangles = bRemoveEnclosedTriangles;
+    settings.DeckNormalMinZ = DeckNormalMinZ;
+    settings.bQuantize = bQuantize;
+    return settings;
+}
+
+/// <summary>
+/// The built hull is stored after the properties in its own binary layout. Loading always reads into a new hull,
+/// so boats that already hold the previous one are not affected.
+/// </summary>
+/// <param name="Ar"></param>
+void UHullPhysicsAssetUserData::Serialize(FArchive& Ar)
+{
+    Super::Serialize(Ar);
+    if (Ar.IsLoading())
+    {
+        Hull = MakeShared<HullData>();
+    }
+    Ar << *Hull;
+}
+
+#if WITH_EDITOR
+/// <summary>
+/// Reads the render mesh of the static mesh that owns this data and builds the hull from it.
+/// </summary>
+void UHullPhysicsAssetUserData::BuildHull()
+{
+    const UStaticMesh* staticMesh = GetTypedOuter<UStaticMesh>();
+    ensure(staticMesh != nullptr);
+    TSharedPtr<HullData> builtHull = MakeShared<HullData>();
+    if (staticMesh != nullptr && BoatMeshManager::ReadRenderMesh(staticMesh, *builtHull))
+    {
+        builtHull->Build(GetBuildSettings());
+        Hull = builtHull;
+    }
+}
+
+void UHullPhysicsAssetUserData::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+    Super::PostEditChangeProperty(PropertyChangedEvent);
+    BuildHull();
+}
+
+void UHullPhysicsAssetUserData::PreSave(FObjectPreSaveContext ObjectSaveContext)
+{
+    Super::PreSave(ObjectSaveContext);
+    // The mesh may have been reimported since the last build
+    BuildHull();
+}
+#endif
\ No newline at end of file
@@ -2,8 +2,7 @@
 #include "PressureDragProvider.h"
 #include "ForceCommands.h"
 #include "ForceProviderHelpers.h"
-#include "StaticMeshWrapper.h"
-#include "WorldWrapper.h"
+#include "HullStateSnapshot.h"
 #include "BoatDebugHUD.h"
 #include "Engine/World.h"
 
@@ -15,8 +14,8 @@
 /// <returns></returns>
 FVector UPressureDragProvider::ComputeForce(const PolyInfo* P, IForceContext context) const
 {
-    StaticMeshWrapper meshAdaptor(context.HullMesh);
-    WorldWrapper worldAdaptor(context.World);
+    SnapshotMeshAdaptor meshAdaptor(*context.HullState);
+    SnapshotWorldAdaptor worldAdaptor(*context.HullState);
     FVector pressureDragForce = PressureDragProviderCore::ComputeForce(P, context.WaterSurface, &meshAdaptor, &worldAdaptor);
     return pressureDragForce;
 }
@@ -4,8 +4,7 @@
 #include "ForceCommands.h"
 #include "PolyInfo.h"
 #include "ForceProviderHelpers.h"
-#include "StaticMeshWrapper.h"
-#include "WorldWrapper.h"
+#include "HullStateSnapshot.h"
 #include "BoatDebugHUD.h"
 
 FString UViscoscityProvider::GetForceProviderName() const
@@ -52,8 +51,8 @@ FVector UViscoscityProvider::ComputeForce(const PolyInfo* info, IForceContext co
     const float M_TO_UU = 100.0f;
     const float FluidDensity = 1025.0f;
 
-    StaticMeshWrapper meshAdaptor(context.HullMesh);
-    WorldWrapper worldAdaptor(context.World);
+    SnapshotMeshAdaptor meshAdaptor(*context.HullState);
+    SnapshotWorldAdaptor worldAdaptor(*context.HullState);
     
     FVector viscousForce = ViscoscityProviderCore::ComputeForce(info, context.WaterSurface, &meshAdaptor,&worldAdaptor);
     return viscousForce;
@@ -161,6 +161,26 @@ protected:
     UPROPERTY(EditDefaultsOnly, Category = "Boat|Viscoscity", meta = (ClampMin = "0.0", ClampMax = "2.0", UIMin = "0.0", UIMax = "2.0"))
     float BackTrianglesKFactor{ 1 };
 
+    // The Boat|Hull settings build the physics hull when the boat spawns, meshes with cooked Hull Physics Data use the settings stored with it
+    // Render vertices closer than this (cm) are merged into one vertex of the physics hull
+    UPROPERTY(EditDefaultsOnly, Category = "Boat|Hull", meta = (ClampMin = "0.0"))
+    float HullWeldTolerance = 0.1f;
+    // Drop hull triangles without any area when the physics hull is built
+    UPROPERTY(EditDefaultsOnly, Category = "Boat|Hull")
+    bool bRemoveDegenerateHullTriangles = true;
+    // Triangles per hull cluster, whole clusters are skipped when dry and not clipped when deep under the water
+    UPROPERTY(EditDefaultsOnly, Category = "Boat|Hull", meta = (ClampMin = "1"))
+    int32 TrianglesPerHullCluster = 96;
+    // Drop hull triangles closed in by the hull on both sides, like cabin interiors, when the physics hull is built
+    UPROPERTY(EditDefaultsOnly, Category = "Boat|Hull")
+    bool bRemoveEnclosedHullTriangles = true;
+    // Hull triangles whose only open side faces at least this much up are decks and are dropped, above 1 keeps them
+    UPROPERTY(EditDefaultsOnly, Category = "Boat|Hull", meta = (ClampMin = "0.0"))
+    float HullDeckNormalMinZ = 0.9f;
+    // Stores the hull vertices as 16 bit fixed point in the mesh bounds, a fraction of the memory for sub millimetre error on boat sized meshes
+    UPROPERTY(EditDefaultsOnly, Category = "Boat|Hull")
+    bool bQuantizeHull = false;
+
 
 private:
     float CalculateIntegratedKFactorForBoat(const PolyInfoList& polyList);
@@ -10,6 +10,7 @@
 #include "ForceProviderBase.h"
 #include "IForceCommand.h"
 #include "BoatRealTimeVertexProvider.h"
+#include "WaterHeightPatch.h"
 #include "BoatForceComponent.generated.h"
 
 
@@ -35,7 +36,18 @@ public:
     
     UPROPERTY(EditAnywhere, Instanced, Category = "Forces")
     TArray<UForceProviderBase*> _Providers;
+
+    // When enabled the water is evaluated once per tick on a small grid around the hull and every force query is a lookup into it.
+    UPROPERTY(EditAnywhere, Category = "Forces|Water Patch")
+    bool bUseWaterHeightPatch = false;
+    // Number of samples along each side of the patch
+    UPROPERTY(EditAnywhere, Category = "Forces|Water Patch", meta = (EditCondition = "bUseWaterHeightPatch", ClampMin = "2", UIMin = "2", UIMax = "256"))
+    int32 WaterPatchResolution = 32;
+    // Extra distance (cm) added around the hull bounds so that the patch still covers the hull while it moves
+    UPROPERTY(EditAnywhere, Category = "Forces|Water Patch", meta = (EditCondition = "bUseWaterHeightPatch", ClampMin = "0.0"))
+    float WaterPatchPadding = 100.0f;
 private:
-    FCriticalSection BoatForceComponentMutex; // Mutex to protect ForceQueue from concurrent access
+    WaterHeightPatch WaterPatch; // Refreshed each tick when bUseWaterHeightPatch is set
+    ForceWorkPartitioner ForcePartitioner; // Keeps the measured cost of the force pass between ticks
     TArray<TUniquePtr<IForceCommand>> ForceQueue;
 };
@@ -9,13 +9,10 @@ class BoatMeshManager : public BoatMeshManagerCore
 {
 public:
 
-    BoatMeshManager(const UStaticMeshComponent* hullMesh, GetBoatForwardDirectionCallback callBack) :
-		BoatMeshManagerCore(MakeUnique<StaticMeshWrapper>(hullMesh),callBack), HullMesh(hullMesh)
-    {
-        CalcLocalVerticesData();
-    }
+    BoatMeshManager(const UStaticMeshComponent* hullMesh, GetBoatForwardDirectionCallback callBack, const HullBuildSettings& buildSettings = HullBuildSettings{});
 
+    // Copies the positions, indices and normals of the first LOD into outHull, the render data must be CPU accessible
+    static bool ReadRenderMesh(const UStaticMesh* staticMesh, HullData& outHull);
 private:
     const UStaticMeshComponent* HullMesh = nullptr; //Does not own the mesh, just a reference to it.
-	void CalcLocalVerticesData();
 };
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "UObject/Object.h"
 #include "IForceProvider.h"
 #include "ForceProviderHelpers.h"
+#include "ForceWorkPartitioner.h"
 #include "ForceProviderBase.generated.h"
 
 UCLASS(Abstract, Blueprintable, EditInlineNew)
@@ -15,10 +16,9 @@ public:
     //Static function that must accumulate force impact from all providers
     static void ContributeForces(TArray<UForceProviderBase*>& forceProviders ,
         IForceContext context, TArray<FCommandPtr>& outQueue,
-        FCriticalSection& Mutex /*For accessing thread unsafe unstructures from context*/);
+        ForceWorkPartitioner& partitioner /*Owned by the caller, keeps the measured cost between ticks*/);
 
-    virtual bool GetFilteredPolygon(const TriangleInfo& triangle, PolyInfo& outPoly, 
-        const FWaterSample& waterSample) const;
+    virtual bool GetFilteredPolygon(const TriangleInfo& triangle, PolyInfo& outPoly) const;
 
     virtual FVector ComputeForce(const PolyInfo* Poly, IForceContext context) const override
     {
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectKey.h"
+#include "HullData.h"
+
+class UStaticMesh;
+
+// Hands out one immutable hull per static mesh and build settings, so boats that use the same mesh share it
+// and only keep their own world space buffers. The registry doesn't keep the hulls alive, a hull is freed
+// with the last boat that uses it and built again by the next one.
+class HullDataRegistry
+{
+public:
+    // Returns the hull cooked into the mesh if it has one, otherwise the shared hull built from its render data
+    static TSharedPtr<const HullData> FindOrBuild(const UStaticMesh* staticMesh, const HullBuildSettings& settings);
+private:
+    struct Entry
+    {
+        HullBuildSettings Settings;
+        TWeakPtr<const HullData> Hull;
+    };
+    static FCriticalSection RegistryMutex;
+    static TMap<TObjectKey<UStaticMesh>, TArray<Entry, TInlineAllocator<1>>> Entries;
+};
\ No newline at end of file
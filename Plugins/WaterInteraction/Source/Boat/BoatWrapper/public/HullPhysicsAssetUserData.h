@@ -0,0 +1,44 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/AssetUserData.h"
+#include "HullData.h"
+#include "HullPhysicsAssetUserData.generated.h"
+
+// Physics hull cooked into a static mesh. Add it to the Asset User Data of a hull mesh and every boat using the mesh
+// loads the built hull with the package instead of reading the render buffers and building it again when it spawns.
+// The hull is rebuilt in the editor whenever the settings change and whenever the mesh is saved or cooked.
+UCLASS(BlueprintType, EditInlineNew, meta = (DisplayName = "Hull Physics Data"))
+class BOATWRAPPER_API UHullPhysicsAssetUserData : public UAssetUserData
+{
+    GENERATED_BODY()
+public:
+    // Same meaning as the Boat|Hull settings of the pawn, which are ignored for meshes that carry this data
+    UPROPERTY(EditAnywhere, Category = "Hull", meta = (ClampMin = "0.0"))
+    float WeldTolerance = 0.1f;
+    UPROPERTY(EditAnywhere, Category = "Hull")
+    bool bRemoveDegenerateTriangles = true;
+    UPROPERTY(EditAnywhere, Category = "Hull", meta = (ClampMin = "1"))
+    int32 TrianglesPerCluster = 96;
+    UPROPERTY(EditAnywhere, Category = "Hull")
+    bool bRemoveEnclosedTriangles = true;
+    UPROPERTY(EditAnywhere, Category = "Hull", meta = (ClampMin = "0.0"))
+    float DeckNormalMinZ = 0.9f;
+    UPROPERTY(EditAnywhere, Category = "Hull")
+    bool bQuantize = false;
+
+    // Null until the hull has been built
+    TSharedPtr<const HullData> GetHullData() const;
+    HullBuildSettings GetBuildSettings() const;
+
+    virtual void Serialize(FArchive& Ar) override;
+#if WITH_EDITOR
+    // Builds the hull from the render data of the mesh this belongs to
+    UFUNCTION(CallInEditor, Category = "Hull")
+    void BuildHull();
+    virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+    virtual void PreSave(FObjectPreSaveContext ObjectSaveContext) override;
+#endif
+private:
+    TSharedPtr<HullData> Hull = MakeShared<HullData>(); // Replaced, never modified, once boats may be holding it
+};
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include "GerstnerWaveComponent.h"
 #include "BoatDebugHUD.h"
 #include "PolyInfo.h"
+#include "HullStateSnapshot.h"
 #include "UObject/Interface.h"
 #include "IForceProvider.generated.h"
 
@@ -16,15 +17,16 @@ class ABoatDebugHUD;
 
 struct IForceContext
 {
-	const TriangleInfoList* HullTriangles;
+	HullTrianglesView HullTriangles;
 	const UStaticMeshComponent* HullMesh;
 	const UWorld* World;
 	const IWaterSurface* WaterSurface;
 	ABoatDebugHUD* DebugHUD;
+	const HullStateSnapshot* HullState; // Captured once for the tick, read it instead of querying HullMesh and World
 
-	IForceContext(const TriangleInfoList* triangles, const UStaticMeshComponent* hullMesh, 
-		const UWorld* world,const IWaterSurface* waterSurface, ABoatDebugHUD* debugHUD) :
-		HullTriangles(triangles), HullMesh(hullMesh), World(world), WaterSurface(waterSurface),DebugHUD(debugHUD)
+	IForceContext(HullTrianglesView triangles, const UStaticMeshComponent* hullMesh, 
+		const UWorld* world,const IWaterSurface* waterSurface, ABoatDebugHUD* debugHUD, const HullStateSnapshot* hullState) :
+		HullTriangles(triangles), HullMesh(hullMesh), World(world), WaterSurface(waterSurface),DebugHUD(debugHUD), HullState(hullState)
 	{
 	}
 };
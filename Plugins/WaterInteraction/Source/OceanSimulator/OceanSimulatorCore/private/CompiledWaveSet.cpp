@@ -0,0 +1,78 @@
+#pragma once
+#include "CompiledWaveSet.h"
+#include "Algo/StableSort.h"
+
+/// <summary>
+/// Computes the per wave constants once so that the samplers don't need any divides in their inner loops.
+/// The waves are stored largest amplitude first so the samplers can stop early, see NumWavesForTolerance.
+/// </summary>
+/// <param name="waves"></param>
+void CompiledWaveSet::Build(const TArray<WaveInfo>& waves)
+{
+    const float UU_TO_M = 0.01f;
+    const int32 numWaves = waves.Num();
+    K.SetNum(numWaves);
+    Omega.SetNum(numWaves);
+    Amplitude.SetNum(numWaves);
+    DirX.SetNum(numWaves);
+    DirY.SetNum(numWaves);
+    Qi.SetNum(numWaves);
+    RemainingAmplitude.SetNum(numWaves + 1);
+    WaterVelocity = FVector::ZeroVector;
+    ++Revision;
+
+    TArray<int32> order;
+    order.SetNum(numWaves);
+    for (int32 i = 0; i < numWaves; ++i)
+    {
+        order[i] = i;
+    }
+    Algo::StableSort(order, [&waves](int32 a, int32 b) { return FMath::Abs(waves[a].Amplitude) > FMath::Abs(waves[b].Amplitude); });
+
+    for (int32 i = 0; i < numWaves; ++i)
+    {
+        const WaveInfo& wave = waves[order[i]];
+        const FVector2D direction = wave.Direction.GetSafeNormal();
+        const float k = 2 * PI / wave.Wavelength;
+        const float qiDenominator = k * wave.Amplitude * numWaves;
+
+        K[i] = k;
+        Omega[i] = wave.Speed * k;
+        Amplitude[i] = wave.Amplitude;
+        DirX[i] = direction.X;
+        DirY[i] = direction.Y;
+        Qi[i] = qiDenominator > KINDA_SMALL_NUMBER ? FMath::Clamp(wave.Steepness / qiDenominator, 0.f, 1.f) : 0.f;
+        WaterVelocity += FVector{ direction * wave.Speed, 0 };
+    }
+    WaterVelocity *= UU_TO_M; // Convert to m/s
+
+    RemainingAmplitude[numWaves] = 0.0f;
+    for (int32 i = numWaves - 1; i >= 0; --i)
+    {
+        RemainingAmplitude[i] = RemainingAmplitude[i + 1] + FMath::Abs(Amplitude[i]);
+    }
+}
+
+int32 CompiledWaveSet::NumWavesForTolerance(float tolerance) const
+{
+    if (tolerance <= 0.0f)
+    {
+        return Num();
+    }
+    // RemainingAmplitude never increases, find the first entry within the tolerance
+    int32 low = 0;
+    int32 high = Num();
+    while (low < high)
+    {
+        const int32 mid = (low + high) / 2;
+        if (RemainingAmplitude[mid] <= tolerance)
+        {
+            high = mid;
+        }
+        else
+        {
+            low = mid + 1;
+        }
+    }
+    return low;
+}
\ No newline at end of file
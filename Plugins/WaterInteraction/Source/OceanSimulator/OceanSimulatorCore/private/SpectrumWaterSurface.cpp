@@ -0,0 +1,417 @@
+#pragma once
+#include "SpectrumWaterSurface.h"
+#include "Async/ParallelFor.h"
+#include "Math/RandomStream.h"
+
+namespace
+{
+    constexpr int32 MaxSpectrumResolution = 1024;
+    constexpr float Gravity = 981.0f; // cm/s^2
+
+    /// <summary>
+    /// In place radix-2 FFT of one line with a positive exponent (spectrum to space), without the 1/n normalization.
+    /// </summary>
+    void InverseFFTLine(float* re, float* im, int32 n, const TArray<float>& twiddleRe, const TArray<float>& twiddleIm, const TArray<int32>& bitReverse)
+    {
+        for (int32 i = 0; i < n; ++i)
+        {
+            const int32 j = bitReverse[i];
+            if (j > i)
+            {
+                Swap(re[i], re[j]);
+                Swap(im[i], im[j]);
+            }
+        }
+        for (int32 length = 2; length <= n; length <<= 1)
+        {
+            const int32 half = length / 2;
+            const int32 twiddleStep = n / length;
+            for (int32 start = 0; start < n; start += length)
+            {
+                for (int32 j = 0; j < half; ++j)
+                {
+                    const float wr = twiddleRe[j * twiddleStep];
+                    const float wi = twiddleIm[j * twiddleStep];
+                    const int32 a = start + j;
+                    const int32 b = a + half;
+                    const float vr = re[b] * wr - im[b] * wi;
+                    const float vi = re[b] * wi + im[b] * wr;
+                    re[b] = re[a] - vr;
+                    im[b] = im[a] - vi;
+                    re[a] += vr;
+                    im[a] += vi;
+                }
+            }
+        }
+    }
+
+    /// <summary>
+    /// 2D inverse FFT of an n x n row major grid, rows first then columns, both in parallel.
+    /// </summary>
+    void InverseFFT2D(TArray<float>& re, TArray<float>& im, int32 n, const TArray<float>& twiddleRe, const TArray<float>& twiddleIm, const TArray<int32>& bitReverse)
+    {
+        ParallelFor(n, [&](int32 row)
+            {
+                InverseFFTLine(&re[row * n], &im[row * n], n, twiddleRe, twiddleIm, bitReverse);
+            });
+        ParallelFor(n, [&](int32 column)
+            {
+                // Gather the column so the butterflies run on contiguous memory
+                float lineRe[MaxSpectrumResolution];
+                float lineIm[MaxSpectrumResolution];
+                for (int32 row = 0; row < n; ++row)
+                {
+                    lineRe[row] = re[row * n + column];
+                    lineIm[row] = im[row * n + column];
+                }
+                InverseFFTLine(lineRe, lineIm, n, twiddleRe, twiddleIm, bitReverse);
+                for (int32 row = 0; row < n; ++row)
+                {
+                    re[row * n + column] = lineRe[row];
+                    im[row * n + column] = lineIm[row];
+                }
+            });
+    }
+}
+
+/// <summary>
+/// Builds the Phillips spectrum amplitudes h0(k) for every frequency of the grid. The spectrum is scaled so that
+/// its significant wave height matches a fully developed sea for the wind speed, times Settings.Amplitude.
+/// </summary>
+/// <param name="settings"></param>
+/// <param name="origin2D"></param>
+/// <param name="baseZ"></param>
+void SpectrumWaterSurfaceCore::InitializeSpectrum(const SpectrumSettings& settings, FVector2D origin2D, float baseZ)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(SpectrumWaterSurfaceCore::InitializeSpectrum);
+    Settings = settings;
+    Origin2D = origin2D;
+    BaseZ = baseZ;
+    N = FMath::Clamp(FMath::RoundUpToPowerOfTwo(FMath::Max(settings.Resolution, 16)), 16u, static_cast<uint32>(MaxSpectrumResolution));
+    ensure(Settings.PatchSize > 0.0f);
+    CellSize = Settings.PatchSize / N;
+
+    const int32 numCells = N * N;
+    H0Re.SetNumZeroed(numCells);
+    H0Im.SetNumZeroed(numCells);
+    H0MinusConjRe.SetNumZeroed(numCells);
+    H0MinusConjIm.SetNumZeroed(numCells);
+    KX.SetNumZeroed(numCells);
+    KY.SetNumZeroed(numCells);
+    InvK.SetNumZeroed(numCells);
+    Omega.SetNumZeroed(numCells);
+    SpectrumARe.SetNumZeroed(numCells);
+    SpectrumAIm.SetNumZeroed(numCells);
+    SpectrumBRe.SetNumZeroed(numCells);
+    SpectrumBIm.SetNumZeroed(numCells);
+    for (Field& field : Fields)
+    {
+        field.Height.SetNumZeroed(numCells);
+        field.DisplacementX.SetNumZeroed(numCells);
+        field.DisplacementY.SetNumZeroed(numCells);
+        field.MinHeight = field.MaxHeight = 0.0f;
+    }
+
+    TwiddleRe.SetNum(N / 2);
+    TwiddleIm.SetNum(N / 2);
+    for (int32 i = 0; i < N / 2; ++i)
+    {
+        const float angle = 2.0f * PI * i / N;
+        TwiddleRe[i] = FMath::Cos(angle);
+        TwiddleIm[i] = FMath::Sin(angle);
+    }
+    const int32 numBits = FMath::FloorLog2(N);
+    BitReverse.SetNum(N);
+    for (int32 i = 0; i < N; ++i)
+    {
+        int32 reversed = 0;
+        for (int32 bit = 0; bit < numBits; ++bit)
+        {
+            reversed |= ((i >> bit) & 1) << (numBits - 1 - bit);
+        }
+        BitReverse[i] = reversed;
+    }
+
+    const float windSpeed = FMath::Max(Settings.WindSpeed, 0.1f) * 100.0f; // cm/s
+    const float largestWave = windSpeed * windSpeed / Gravity;
+    const FVector2D windDirection = Settings.WindDirection.GetSafeNormal();
+    const float cutoff = Settings.SmallWaveCutoff;
+
+    // Phillips spectrum, without the constant since it is normalized below
+    TArray<float> phillips;
+    phillips.SetNumZeroed(numCells);
+    double totalPower = 0.0;
+    for (int32 y = 0; y < N; ++y)
+    {
+        for (int32 x = 0; x < N; ++x)
+        {
+            const int32 index = y * N + x;
+            // FFT ordering, the upper half of the indices are the negative frequencies
+            const int32 mx = x < N / 2 ? x : x - N;
+            const int32 my = y < N / 2 ? y : y - N;
+            const float kx = 2.0f * PI * mx / Settings.PatchSize;
+            const float ky = 2.0f * PI * my / Settings.PatchSize;
+            const float k = FMath::Sqrt(kx * kx + ky * ky);
+            KX[index] = kx;
+            KY[index] = ky;
+            if (k < KINDA_SMALL_NUMBER)
+            {
+                continue;
+            }
+            InvK[index] = 1.0f / k;
+            Omega[index] = FMath::Sqrt(Gravity * k);
+
+            const float kDotWind = (kx * windDirection.X + ky * windDirection.Y) / k;
+            float power = FMath::Exp(-1.0f / FMath::Square(k * largestWave)) / FMath::Square(k * k);
+            power *= kDotWind * kDotWind;
+            power *= FMath::Exp(-k * k * cutoff * cutoff);
+            if (kDotWind < 0.0f)
+            {
+                power *= 0.07f; // Waves travelling against the wind are mostly damped out
+            }
+            phillips[index] = power;
+            totalPower += power;
+        }
+    }
+
+    // E|h(k,t)|^2 = P(k) + P(-k), so the height variance is twice the total power.
+    // A fully developed sea has a significant wave height of 0.21 V^2 / g, and Hs = 4 * RMS height.
+    const float significantWaveHeight = 0.21f * windSpeed * windSpeed / Gravity;
+    const double targetVariance = FMath::Square(significantWaveHeight * 0.25f * Settings.Amplitude);
+    const double powerScale = totalPower > 0.0 ? targetVariance / (2.0 * totalPower) : 0.0;
+
+    FRandomStream random(Settings.Seed);
+    for (int32 index = 0; index < numCells; ++index)
+    {
+        const float amplitude = FMath::Sqrt(static_cast<float>(phillips[index] * powerScale) * 0.5f);
+        // Box-Muller for two independent gaussians
+        const float u1 = FMath::Max(random.GetFraction(), SMALL_NUMBER);
+        const float u2 = random.GetFraction();
+        const float radius = FMath::Sqrt(-2.0f * FMath::Loge(u1));
+        H0Re[index] = radius * FMath::Cos(2.0f * PI * u2) * amplitude;
+        H0Im[index] = radius * FMath::Sin(2.0f * PI * u2) * amplitude;
+    }
+    for (int32 y = 0; y < N; ++y)
+    {
+        for (int32 x = 0; x < N; ++x)
+        {
+            const int32 minusIndex = ((N - y) % N) * N + (N - x) % N;
+            H0MinusConjRe[y * N + x] = H0Re[minusIndex];
+            H0MinusConjIm[y * N + x] = -H0Im[minusIndex];
+        }
+    }
+
+    Synthesize(0.0f);
+    PublishSynthesized();
+}
+
+/// <summary>
+/// Evolves h0 to h(k,t) = h0(k) e^(i w t) + conj(h0(-k)) e^(-i w t) and transforms it to space.
+/// Height and X displacement share one complex transform since both are real, Y displacement uses the second.
+/// The Nyquist row and column are their own mirror, the displacement there isn't Hermitian and would leak into the
+/// height that shares its transform, so the displacement is left out of them.
+/// </summary>
+/// <param name="time"></param>
+void SpectrumWaterSurfaceCore::Synthesize(float time)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(SpectrumWaterSurfaceCore::Synthesize);
+    if (N == 0)
+    {
+        return;
+    }
+    const int32 numCells = N * N;
+    ParallelFor(N, [&](int32 row)
+        {
+            const bool isNyquistRow = row == N / 2;
+            for (int32 index = row * N; index < (row + 1) * N; ++index)
+            {
+                const bool hasDisplacement = !isNyquistRow && index - row * N != N / 2;
+                float s, c;
+                FMath::SinCos(&s, &c, Omega[index] * time);
+                const float hr = H0Re[index] * c - H0Im[index] * s + H0MinusConjRe[index] * c + H0MinusConjIm[index] * s;
+                const float hi = H0Re[index] * s + H0Im[index] * c + H0MinusConjIm[index] * c - H0MinusConjRe[index] * s;
+                // D(k) = -i k/|k| h(k)
+                const float dirX = hasDisplacement ? KX[index] * InvK[index] : 0.0f;
+                const float dirY = hasDisplacement ? KY[index] * InvK[index] : 0.0f;
+                const float dxr = dirX * hi;
+                const float dxi = -dirX * hr;
+                SpectrumARe[index] = hr - dxi;
+                SpectrumAIm[index] = hi + dxr;
+                SpectrumBRe[index] = dirY * hi;
+                SpectrumBIm[index] = -dirY * hr;
+            }
+        });
+
+    InverseFFT2D(SpectrumARe, SpectrumAIm, N, TwiddleRe, TwiddleIm, BitReverse);
+    InverseFFT2D(SpectrumBRe, SpectrumBIm, N, TwiddleRe, TwiddleIm, BitReverse);
+
+    Field& field = Fields[WriteField];
+    float minHeight = TNumericLimits<float>::Max();
+    float maxHeight = TNumericLimits<float>::Lowest();
+    float maxDisplacement = 0.0f;
+    for (int32 index = 0; index < numCells; ++index)
+    {
+        field.Height[index] = SpectrumARe[index];
+        field.DisplacementX[index] = SpectrumAIm[index] * Settings.Choppiness;
+        field.DisplacementY[index] = SpectrumBRe[index] * Settings.Choppiness;
+        minHeight = FMath::Min(minHeight, SpectrumARe[index]);
+        maxHeight = FMath::Max(maxHeight, SpectrumARe[index]);
+        maxDisplacement = FMath::Max3(maxDisplacement, FMath::Abs(field.DisplacementX[index]), FMath::Abs(field.DisplacementY[index]));
+    }
+    field.MinHeight = minHeight;
+    field.MaxHeight = maxHeight;
+    field.MaxDisplacement = maxDisplacement;
+}
+
+void SpectrumWaterSurfaceCore::PublishSynthesized()
+{
+    const int32 published = WriteField;
+    WriteField = PreviousField;
+    PreviousField = FrontField.load(std::memory_order_relaxed);
+    FrontField.store(published, std::memory_order_release);
+}
+
+/// <summary>
+/// Cell and weights of the bilinear lookup of the lattice position XY in the tiled field.
+/// </summary>
+/// <param name="XY"></param>
+/// <returns></returns>
+SpectrumWaterSurfaceCore::FieldLookup SpectrumWaterSurfaceCore::LookupField(const FVector2D& XY) const
+{
+    // Wrap in double precision so the lookup stays accurate far away from the origin
+    const double u = FMath::Fmod(XY.X - Origin2D.X, static_cast<double>(Settings.PatchSize)) / CellSize;
+    const double v = FMath::Fmod(XY.Y - Origin2D.Y, static_cast<double>(Settings.PatchSize)) / CellSize;
+    const double cellX = FMath::Floor(u);
+    const double cellY = FMath::Floor(v);
+    const int32 mask = N - 1;
+    const int32 x0 = static_cast<int32>(cellX) & mask;
+    const int32 y0 = static_cast<int32>(cellY) & mask;
+    const int32 x1 = (x0 + 1) & mask;
+    const int32 y1 = (y0 + 1) & mask;
+    return FieldLookup{ y0 * N + x0, y0 * N + x1, y1 * N + x0, y1 * N + x1, static_cast<float>(u - cellX), static_cast<float>(v - cellY) };
+}
+
+/// <summary>
+/// Surface at XY. The field stores the height of lattice points that the choppiness moves sideways, so the lattice point
+/// that lands on XY is found first with a few fixed point steps, p = XY - D(p), and its height is the height at XY.
+/// The normal comes from the bilinear slopes of the height at that point, carried through the Jacobian of the displacement.
+/// </summary>
+/// <param name="field"></param>
+/// <param name="XY"></param>
+/// <returns></returns>
+FWaterSample SpectrumWaterSurfaceCore::SampleField(const Field& field, const FVector2D& XY) const
+{
+    constexpr int32 InverseDisplacementSteps = 3;
+    if (N == 0)
+    {
+        return { FVector{},FVector{},false };
+    }
+    auto bilinear = [](const TArray<float>& values, const FieldLookup& lookup)
+        {
+            return FMath::Lerp(FMath::Lerp(values[lookup.I00], values[lookup.I10], lookup.TX), FMath::Lerp(values[lookup.I01], values[lookup.I11], lookup.TX), lookup.TY);
+        };
+    // Slopes of the bilinear values along the lattice axes, per cm
+    auto slopes = [this](const TArray<float>& values, const FieldLookup& lookup)
+        {
+            return FVector2D{ FMath::Lerp(values[lookup.I10] - values[lookup.I00], values[lookup.I11] - values[lookup.I01], lookup.TY) / CellSize,
+                FMath::Lerp(values[lookup.I01] - values[lookup.I00], values[lookup.I11] - values[lookup.I10], lookup.TX) / CellSize };
+        };
+
+    FVector2D latticeXY = XY;
+    FieldLookup lookup = LookupField(latticeXY);
+    if (field.MaxDisplacement > 0.0f)
+    {
+        for (int32 step = 0; step < InverseDisplacementSteps; ++step)
+        {
+            latticeXY = XY - FVector2D{ bilinear(field.DisplacementX, lookup), bilinear(field.DisplacementY, lookup) };
+            lookup = LookupField(latticeXY);
+        }
+    }
+    const float height = bilinear(field.Height, lookup);
+    FVector2D heightSlope = slopes(field.Height, lookup);
+    if (field.MaxDisplacement > 0.0f)
+    {
+        // XY = p + D(p), so the slope over XY is the slope over p times the inverse transpose of J = I + dD/dp
+        const FVector2D displacementXSlope = slopes(field.DisplacementX, lookup);
+        const FVector2D displacementYSlope = slopes(field.DisplacementY, lookup);
+        const float j00 = 1.0f + displacementXSlope.X, j01 = displacementXSlope.Y;
+        const float j10 = displacementYSlope.X, j11 = 1.0f + displacementYSlope.Y;
+        const float determinant = j00 * j11 - j01 * j10;
+        if (determinant > KINDA_SMALL_NUMBER)
+        {
+            heightSlope = FVector2D{ j11 * heightSlope.X - j10 * heightSlope.Y, j00 * heightSlope.Y - j01 * heightSlope.X } / determinant;
+        }
+    }
+
+    FWaterSample waterSample;
+    waterSample.Position = FVector{ XY.X, XY.Y, BaseZ + height };
+    waterSample.Normal = FVector{ -heightSlope.X, -heightSlope.Y, 1.0f }.GetSafeNormal();
+    waterSample.IsValid = true;
+    return waterSample;
+}
+
+FWaterSample SpectrumWaterSurfaceCore::SampleHeightAt(const FVector2D& XY, float time) const
+{
+    return SampleField(Fields[FrontField.load(std::memory_order_acquire)], XY);
+}
+
+void SpectrumWaterSurfaceCore::SampleHeights(TArrayView<const FVector2D> XY, float time, TArrayView<FWaterSample> OutSamples) const
+{
+    check(OutSamples.Num() >= XY.Num());
+    // Read the front index once so the whole batch comes from the same field
+    const Field& field = Fields[FrontField.load(std::memory_order_acquire)];
+    for (int32 i = 0; i < XY.Num(); ++i)
+    {
+        OutSamples[i] = SampleField(field, XY[i]);
+    }
+}
+
+FVector SpectrumWaterSurfaceCore::GetWaterVelocity() const
+{
+    return FVector{}; // The spectrum is a sea state without a mean current
+}
+
+/// <summary>
+/// Range of the published heights over the region. Small regions scan the grid points of the cells they touch,
+/// bilinear lookups can't leave that range. The lattice points that land in the region can be up to the largest displacement
+/// away from it, so the region grows by that much first. Regions too big to scan cheaply use the range of the whole field.
+/// </summary>
+/// <param name="region"></param>
+/// <param name="time">Ignored, like in the samplers</param>
+/// <returns></returns>
+FFloatInterval SpectrumWaterSurfaceCore::GetHeightBounds(const FBox2D& region, float time) const
+{
+    constexpr int32 MaxScannedPoints = 4096;
+    if (N == 0)
+    {
+        return FFloatInterval();
+    }
+    const Field& field = Fields[FrontField.load(std::memory_order_acquire)];
+    const FBox2D latticeRegion = region.ExpandBy(field.MaxDisplacement);
+    const double u = FMath::Fmod(latticeRegion.Min.X - Origin2D.X, static_cast<double>(Settings.PatchSize)) / CellSize;
+    const double v = FMath::Fmod(latticeRegion.Min.Y - Origin2D.Y, static_cast<double>(Settings.PatchSize)) / CellSize;
+    const int32 cellX = FMath::FloorToInt32(u);
+    const int32 cellY = FMath::FloorToInt32(v);
+    // The region can start anywhere inside its first cell, count the points up to the end of the cell it stops in
+    const int32 pointsX = FMath::FloorToInt32((u - cellX) + (latticeRegion.Max.X - latticeRegion.Min.X) / CellSize) + 2;
+    const int32 pointsY = FMath::FloorToInt32((v - cellY) + (latticeRegion.Max.Y - latticeRegion.Min.Y) / CellSize) + 2;
+    if (pointsX >= N || pointsY >= N || pointsX * pointsY > MaxScannedPoints)
+    {
+        return FFloatInterval(BaseZ + field.MinHeight, BaseZ + field.MaxHeight);
+    }
+
+    const int32 mask = N - 1;
+    float minHeight = TNumericLimits<float>::Max();
+    float maxHeight = TNumericLimits<float>::Lowest();
+    for (int32 y = 0; y < pointsY; ++y)
+    {
+        const int32 rowStart = ((cellY + y) & mask) * N;
+        for (int32 x = 0; x < pointsX; ++x)
+        {
+            const float height = field.Height[rowStart + ((cellX + x) & mask)];
+            minHeight = FMath::Min(minHeight, height);
+            maxHeight = FMath::Max(maxHeight, height);
+        }
+    }
+    return FFloatInterval(BaseZ + minHeight, BaseZ + maxHeight);
+}
\ No newline at end of file
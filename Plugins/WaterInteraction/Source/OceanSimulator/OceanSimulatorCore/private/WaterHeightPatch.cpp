@@ -0,0 +1,181 @@
+#pragma once
+#include "WaterHeightPatch.h"
+#include "Async/ParallelFor.h"
+
+/// <summary>
+/// Evaluates the source surface on a Resolution x Resolution grid covering bounds.
+/// Each row is sampled with one batched call and the rows run in parallel.
+/// </summary>
+/// <param name="source"></param>
+/// <param name="bounds"></param>
+/// <param name="resolution"></param>
+/// <param name="time"></param>
+void WaterHeightPatch::Refresh(const IWaterSurface* source, const FBox2D& bounds, int32 resolution, float time)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(WaterHeightPatch::Refresh);
+    ensure(source != nullptr);
+    Source = source;
+    Resolution = FMath::Max(resolution, 2);
+    if (Source == nullptr)
+    {
+        return;
+    }
+
+    const int32 numSamples = Resolution * Resolution;
+    Heights.SetNumUninitialized(numSamples, EAllowShrinking::No);
+    Valid.SetNumUninitialized(numSamples, EAllowShrinking::No);
+    SamplePoints.SetNumUninitialized(numSamples, EAllowShrinking::No);
+    Samples.SetNumUninitialized(numSamples, EAllowShrinking::No);
+
+    PatchOrigin = bounds.Min;
+    CellSize = (bounds.Max - bounds.Min) / (Resolution - 1);
+    InvCellSize = FVector2D{ CellSize.X > 0 ? 1.0 / CellSize.X : 0.0, CellSize.Y > 0 ? 1.0 / CellSize.Y : 0.0 };
+
+    ParallelFor(Resolution, [&](int32 row)
+        {
+            const int32 rowStart = row * Resolution;
+            for (int32 column = 0; column < Resolution; ++column)
+            {
+                SamplePoints[rowStart + column] = PatchOrigin + FVector2D{ column * CellSize.X, row * CellSize.Y };
+            }
+            Source->SampleHeights(TArrayView<const FVector2D>(&SamplePoints[rowStart], Resolution), time,
+                TArrayView<FWaterSample>(&Samples[rowStart], Resolution));
+            for (int32 column = 0; column < Resolution; ++column)
+            {
+                Heights[rowStart + column] = Samples[rowStart + column].Position.Z;
+                Valid[rowStart + column] = Samples[rowStart + column].IsValid;
+            }
+        });
+}
+
+/// <summary>
+/// Bilinear lookup into the grid. Returns false when the point is outside the patch or
+/// touches a cell the source could not sample.
+/// </summary>
+/// <param name="XY"></param>
+/// <param name="outSample"></param>
+/// <returns></returns>
+bool WaterHeightPatch::Lookup(const FVector2D& XY, FWaterSample& outSample) const
+{
+    if (Resolution < 2 || Heights.Num() != Resolution * Resolution)
+    {
+        return false;
+    }
+    const float fx = (XY.X - PatchOrigin.X) * InvCellSize.X;
+    const float fy = (XY.Y - PatchOrigin.Y) * InvCellSize.Y;
+    if (fx < 0 || fy < 0 || fx > Resolution - 1 || fy > Resolution - 1)
+    {
+        return false;
+    }
+    const int32 x0 = FMath::Min(FMath::FloorToInt32(fx), Resolution - 2);
+    const int32 y0 = FMath::Min(FMath::FloorToInt32(fy), Resolution - 2);
+    const int32 i00 = y0 * Resolution + x0;
+    const int32 i10 = i00 + 1;
+    const int32 i01 = i00 + Resolution;
+    const int32 i11 = i01 + 1;
+    if (!Valid[i00] || !Valid[i10] || !Valid[i01] || !Valid[i11])
+    {
+        return false;
+    }
+    const float tx = fx - x0;
+    const float ty = fy - y0;
+    const float h0 = FMath::Lerp(Heights[i00], Heights[i10], tx);
+    const float h1 = FMath::Lerp(Heights[i01], Heights[i11], tx);
+
+    //Slopes of the bilinear surface give the normal
+    const float dhdx = FMath::Lerp(Heights[i10] - Heights[i00], Heights[i11] - Heights[i01], ty) * InvCellSize.X;
+    const float dhdy = (h1 - h0) * InvCellSize.Y;
+
+    outSample.Position = FVector{ XY.X, XY.Y, FMath::Lerp(h0, h1, ty) };
+    outSample.Normal = FVector{ -dhdx, -dhdy, 1.0f }.GetSafeNormal();
+    outSample.IsValid = true;
+    return true;
+}
+
+FWaterSample WaterHeightPatch::SampleHeightAt(const FVector2D& XY, float time) const
+{
+    FWaterSample waterSample;
+    if (Lookup(XY, waterSample))
+    {
+        return waterSample;
+    }
+    if (Source == nullptr)
+    {
+        return { FVector{},FVector{},false };
+    }
+    return Source->SampleHeightAt(XY, time);
+}
+
+void WaterHeightPatch::SampleHeights(TArrayView<const FVector2D> XY, float time, TArrayView<FWaterSample> OutSamples) const
+{
+    check(OutSamples.Num() >= XY.Num());
+    for (int32 i = 0; i < XY.Num(); ++i)
+    {
+        if (!Lookup(XY[i], OutSamples[i]))
+        {
+            OutSamples[i] = Source != nullptr ? Source->SampleHeightAt(XY[i], time) : FWaterSample{ FVector{},FVector{},false };
+        }
+    }
+}
+
+FVector WaterHeightPatch::GetWaterVelocity() const
+{
+    return Source != nullptr ? Source->GetWaterVelocity() : FVector{};
+}
+
+/// <summary>
+/// A bilinear lookup never leaves the range of the four grid heights around it, so the bounds are the range of the grid
+/// points of every cell the region touches. Where the region leaves the patch or touches a cell the source could not sample,
+/// the lookups fall back to the source, so its bounds are included too.
+/// </summary>
+/// <param name="region"></param>
+/// <param name="time"></param>
+/// <returns></returns>
+FFloatInterval WaterHeightPatch::GetHeightBounds(const FBox2D& region, float time) const
+{
+    FFloatInterval bounds;
+    bool coveredByGrid = false;
+    if (Resolution >= 2 && Heights.Num() == Resolution * Resolution)
+    {
+        const FBox2D patchBounds(PatchOrigin, PatchOrigin + CellSize * (Resolution - 1));
+        if (patchBounds.Intersect(region))
+        {
+            auto toCell = [&](double offset, double invCellSize) { return FMath::Clamp(FMath::FloorToInt32(offset * invCellSize), 0, Resolution - 2); };
+            const int32 x0 = toCell(region.Min.X - PatchOrigin.X, InvCellSize.X);
+            const int32 x1 = toCell(region.Max.X - PatchOrigin.X, InvCellSize.X) + 1;
+            const int32 y0 = toCell(region.Min.Y - PatchOrigin.Y, InvCellSize.Y);
+            const int32 y1 = toCell(region.Max.Y - PatchOrigin.Y, InvCellSize.Y) + 1;
+            bool allValid = true;
+            for (int32 y = y0; y <= y1; ++y)
+            {
+                for (int32 x = x0; x <= x1; ++x)
+                {
+                    const int32 index = y * Resolution + x;
+                    if (Valid[index])
+                    {
+                        bounds.Include(Heights[index]);
+                    }
+                    else
+                    {
+                        allValid = false;
+                    }
+                }
+            }
+            coveredByGrid = allValid && patchBounds.IsInside(region);
+        }
+    }
+    if (!coveredByGrid)
+    {
+        if (Source == nullptr)
+        {
+            return bounds;
+        }
+        const FFloatInterval sourceBounds = Source->GetHeightBounds(region, time);
+        if (sourceBounds.IsValid())
+        {
+            bounds.Include(sourceBounds.Min);
+            bounds.Include(sourceBounds.Max);
+        }
+    }
+    return bounds;
+}
\ No newline at end of file
@@ -1,26 +1,195 @@
 #pragma once
 #include "WaterSurface.h"
+#include "Math/VectorRegister.h"
+
+/// <summary>
+/// March the ray with one batched sample call, then bisect the first interval where the height above the water changes sign.
+/// Points where the surface is not valid count as above the water. The normal is taken from central differences
+/// so it is correct for every surface, including the ones that only return an up vector.
+/// </summary>
+/// <param name="origin"></param>
+/// <param name="direction"></param>
+/// <param name="maxDistance"></param>
+/// <param name="time"></param>
+/// <param name="outHit"></param>
+/// <returns>True when the ray crosses the surface within maxDistance</returns>
+bool IWaterSurface::Raycast(const FVector& origin, const FVector& direction, float maxDistance, float time, FWaterRayHit& outHit) const
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(IWaterSurface::Raycast);
+    constexpr int32 MarchSteps = 64;
+    constexpr int32 BisectionSteps = 16;
+    if (maxDistance <= 0.0f)
+    {
+        return false;
+    }
+
+    auto heightAbove = [&](const FWaterSample& waterSample, float distance)
+        {
+            const double rayZ = origin.Z + direction.Z * distance;
+            return waterSample.IsValid ? rayZ - waterSample.Position.Z : UE_DOUBLE_BIG_NUMBER;
+        };
+    FVector2D marchXY[MarchSteps + 1];
+    FWaterSample marchSamples[MarchSteps + 1];
+    const float stepLength = maxDistance / MarchSteps;
+    for (int32 i = 0; i <= MarchSteps; ++i)
+    {
+        marchXY[i] = FVector2D(origin + direction * (i * stepLength));
+    }
+    SampleHeights(MakeArrayView(marchXY), time, MakeArrayView(marchSamples));
+
+    int32 crossing = INDEX_NONE;
+    const bool startsAbove = heightAbove(marchSamples[0], 0.0f) >= 0.0;
+    for (int32 i = 1; i <= MarchSteps; ++i)
+    {
+        if ((heightAbove(marchSamples[i], i * stepLength) >= 0.0) != startsAbove)
+        {
+            crossing = i;
+            break;
+        }
+    }
+    if (crossing == INDEX_NONE)
+    {
+        return false;
+    }
+
+    float nearDistance = (crossing - 1) * stepLength;
+    float farDistance = crossing * stepLength;
+    for (int32 i = 0; i < BisectionSteps; ++i)
+    {
+        const float midDistance = 0.5f * (nearDistance + farDistance);
+        const FWaterSample waterSample = SampleHeightAt(FVector2D(origin + direction * midDistance), time);
+        if ((heightAbove(waterSample, midDistance) >= 0.0) == startsAbove)
+        {
+            nearDistance = midDistance;
+        }
+        else
+        {
+            farDistance = midDistance;
+        }
+    }
+
+    outHit.Distance = 0.5f * (nearDistance + farDistance);
+    outHit.Position = origin + direction * outHit.Distance;
+    constexpr float NormalDelta = 10.0f;
+    const FVector2D hitXY(outHit.Position);
+    const FVector2D slopeXY[4] = { hitXY + FVector2D(NormalDelta, 0), hitXY - FVector2D(NormalDelta, 0), hitXY + FVector2D(0, NormalDelta), hitXY - FVector2D(0, NormalDelta) };
+    FWaterSample slopeSamples[4];
+    SampleHeights(MakeArrayView(slopeXY), time, MakeArrayView(slopeSamples));
+    if (slopeSamples[0].IsValid && slopeSamples[1].IsValid && slopeSamples[2].IsValid && slopeSamples[3].IsValid)
+    {
+        const double dhdx = (slopeSamples[0].Position.Z - slopeSamples[1].Position.Z) / (2.0 * NormalDelta);
+        const double dhdy = (slopeSamples[2].Position.Z - slopeSamples[3].Position.Z) / (2.0 * NormalDelta);
+        outHit.Normal = FVector(-dhdx, -dhdy, 1.0).GetSafeNormal();
+    }
+    else
+    {
+        outHit.Normal = FVector::UpVector;
+    }
+    return true;
+}
+
+/// <summary>
+/// Stores the waves and rebuilds the compiled wave set that the samplers read from.
+/// </summary>
+/// <param name="waves"></param>
+void WaterSurfaceCore::SetWaves(const TArray<WaveInfo>& waves)
+{
+    Waves = waves;
+    WaveSet.Build(Waves);
+}
 
 FVector WaterSurfaceCore::GetWaterVelocity() const
 {
-    if (!WaterVelocity.IsSet())
+    return WaveSet.WaterVelocity;
+}
+
+namespace
+{
+    // Range of sin over [center - halfWidth, center + halfWidth], halfWidth must be below PI
+    void SineRange(double center, double halfWidth, double& outMin, double& outMax)
     {
-        const float UU_TO_M = 0.01f;
-        FVector waterVelocity{};
-        for (const auto& wave : Waves)
+        double start = FMath::Fmod(center - halfWidth, UE_DOUBLE_TWO_PI);
+        if (start < 0.0)
+        {
+            start += UE_DOUBLE_TWO_PI;
+        }
+        const double end = start + 2.0 * halfWidth; // Less than 4*PI, so there are two peaks and two troughs to check
+        const double sinStart = FMath::Sin(start);
+        const double sinEnd = FMath::Sin(end);
+        outMin = FMath::Min(sinStart, sinEnd);
+        outMax = FMath::Max(sinStart, sinEnd);
+        auto contains = [&](double phase) { return start <= phase && phase <= end; };
+        if (contains(0.5 * UE_DOUBLE_PI) || contains(2.5 * UE_DOUBLE_PI))
+        {
+            outMax = 1.0;
+        }
+        if (contains(1.5 * UE_DOUBLE_PI) || contains(3.5 * UE_DOUBLE_PI))
         {
-            waterVelocity += FVector{ wave.Direction.GetSafeNormal() * wave.Speed,0 };
+            outMin = -1.0;
         }
-        WaterVelocity = waterVelocity * UU_TO_M; // Convert to m/s
     }
-    return WaterVelocity.GetValue();
+}
 
+/// <summary>
+/// Bounds the wave sum over the region one wave at a time. The phase of a wave is linear in XY, so over the region it
+/// spans an interval around the phase at the centre, and the wave stays within the range of sin over that interval.
+/// Waves longer than the region keep a tight range, waves shorter than it fall back to their full amplitude.
+/// A small margin covers the difference between the vectorized samplers and the double precision sum here.
+/// </summary>
+/// <param name="region"></param>
+/// <param name="time"></param>
+/// <returns></returns>
+FFloatInterval WaterSurfaceCore::GetHeightBounds(const FBox2D& region, float time) const
+{
+    FVector2D localMin = region.Min - Origin2D;
+    FVector2D localMax = region.Max - Origin2D;
+    if (!bUnbounded)
+    {
+        localMin = FVector2D::Max(localMin, FVector2D::ZeroVector);
+        localMax = FVector2D::Min(localMax, FVector2D(GridWorldSize));
+        if (localMin.X > localMax.X || localMin.Y > localMax.Y)
+        {
+            return FFloatInterval(); // The region is outside the grid, nothing there is water
+        }
+    }
+    const FVector2D center = 0.5 * (localMin + localMax);
+    const FVector2D halfSize = 0.5 * (localMax - localMin);
+
+    double minHeight = BaseZ;
+    double maxHeight = BaseZ;
+    for (int32 i = 0; i < WaveSet.Num(); ++i)
+    {
+        const double amplitude = FMath::Abs(WaveSet.Amplitude[i]);
+        const double halfWidth = static_cast<double>(WaveSet.K[i]) * (FMath::Abs(WaveSet.DirX[i]) * halfSize.X + FMath::Abs(WaveSet.DirY[i]) * halfSize.Y);
+        if (halfWidth >= UE_DOUBLE_PI)
+        {
+            minHeight -= amplitude;
+            maxHeight += amplitude;
+            continue;
+        }
+        const double centerPhase = static_cast<double>(WaveSet.K[i]) * (WaveSet.DirX[i] * center.X + WaveSet.DirY[i] * center.Y) + static_cast<double>(WaveSet.Omega[i]) * time;
+        double sinMin, sinMax;
+        SineRange(centerPhase, halfWidth, sinMin, sinMax);
+        if (WaveSet.Amplitude[i] >= 0.0f)
+        {
+            minHeight += amplitude * sinMin;
+            maxHeight += amplitude * sinMax;
+        }
+        else
+        {
+            minHeight -= amplitude * sinMax;
+            maxHeight -= amplitude * sinMin;
+        }
+    }
+    const double totalAmplitude = WaveSet.RemainingAmplitude.Num() > 0 ? WaveSet.RemainingAmplitude[0] : 0.0;
+    const double margin = 1e-3 * totalAmplitude + UE_KINDA_SMALL_NUMBER;
+    return FFloatInterval(static_cast<float>(minHeight - margin), static_cast<float>(maxHeight + margin));
 }
 
 FWaterSample WaterSurfaceCore::SampleHeightAt(const FVector2D& WorldXY, float time) const
 {
     FVector2D LocalXY = WorldXY - Origin2D;
-    if (LocalXY.X <0 || LocalXY.X > GridWorldSize || LocalXY.Y <0 || LocalXY.Y > GridWorldSize)
+    if (!IsInsideGrid(LocalXY.X, LocalXY.Y))
     {
         return { FVector{},FVector{},false };
     }
@@ -30,16 +199,138 @@ FWaterSample WaterSurfaceCore::SampleHeightAt(const FVector2D& WorldXY, float ti
     waterSample.Position.Y = WorldXY.Y;
     waterSample.Position.Z = BaseZ; // Initialize Z to actorZ
 
-    for (auto wave : Waves)
+    // The phase is summed in double precision, far from the origin or late in the game a float phase loses the small waves
+    const double x = LocalXY.X;
+    const double y = LocalXY.Y;
+    for (int32 i = 0; i < WaveSet.Num(); ++i)
     {
-        float frequency = 2 * PI / wave.Wavelength;
-        float Qi = wave.Steepness / (frequency * wave.Amplitude * Waves.Num());
-        Qi = FMath::Clamp(Qi, 0.f, 1.f);
-        float phaseConstant = wave.Speed * 2 * PI / wave.Wavelength;
-
-        waterSample.Position.Z += wave.Amplitude * FMath::Sin(frequency * FVector2D::DotProduct(wave.Direction, FVector2D(LocalXY.X, LocalXY.Y)) + phaseConstant * time);
+        const double phase = static_cast<double>(WaveSet.K[i]) * (WaveSet.DirX[i] * x + WaveSet.DirY[i] * y) + static_cast<double>(WaveSet.Omega[i]) * time;
+        waterSample.Position.Z += WaveSet.Amplitude[i] * FMath::Sin(phase);
     }
 
+    waterSample.Normal = FVector::UpVector;
     waterSample.IsValid = true;
     return waterSample;
+}
+
+/// <summary>
+/// Batched version of SampleHeightAt. The wave constants come from the compiled wave set and the
+/// wave sum is evaluated 4 points at a time with VectorRegister4Float, so a whole hull can be sampled
+/// with a single virtual call.
+/// The lanes work with float offsets from the first point of the batch. The phase at that anchor is computed
+/// in double precision and wrapped to [0, 2*PI), so the result doesn't degrade far from the origin.
+/// </summary>
+/// <param name="XY"></param>
+/// <param name="time"></param>
+/// <param name="OutSamples"></param>
+void WaterSurfaceCore::SampleHeights(TArrayView<const FVector2D> XY, float time, TArrayView<FWaterSample> OutSamples) const
+{
+    SampleLeadingWaves(XY, time, WaveSet.Num(), OutSamples);
+}
+
+/// <summary>
+/// Batched sampling that skips the smallest waves, as long as together they can't move the surface by more than maxError.
+/// </summary>
+/// <param name="XY"></param>
+/// <param name="time"></param>
+/// <param name="maxError"></param>
+/// <param name="OutSamples"></param>
+void WaterSurfaceCore::SampleHeightsApprox(TArrayView<const FVector2D> XY, float time, float maxError, TArrayView<FWaterSample> OutSamples) const
+{
+    SampleLeadingWaves(XY, time, WaveSet.NumWavesForTolerance(maxError), OutSamples);
+}
+
+/// <summary>
+/// Sums the first numWaves waves of the compiled set, they are sorted by amplitude so these are the largest ones.
+/// The waves are taken in chunks whose splatted constants fit on the stack, so any number of waves is summed without
+/// allocating. Each chunk adds to the heights the previous ones left in OutSamples, in the same order as one long sum.
+/// </summary>
+/// <param name="XY"></param>
+/// <param name="time"></param>
+/// <param name="numWaves"></param>
+/// <param name="OutSamples"></param>
+void WaterSurfaceCore::SampleLeadingWaves(TArrayView<const FVector2D> XY, float time, int32 numWaves, TArrayView<FWaterSample> OutSamples) const
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(WaterSurfaceCore::SampleHeights);
+    check(OutSamples.Num() >= XY.Num());
+    check(numWaves <= WaveSet.Num());
+
+    //Per wave constants, splatted once per call so the inner loop is only multiply-adds and a sin
+    struct FWaveLanes
+    {
+        VectorRegister4Float KDirX;
+        VectorRegister4Float KDirY;
+        VectorRegister4Float PhaseOffset;
+        VectorRegister4Float Amplitude;
+    };
+    if (XY.Num() == 0)
+    {
+        return;
+    }
+    const FVector2D anchor = XY[0] - Origin2D;
+    for (int32 i = 0; i < XY.Num(); ++i)
+    {
+        OutSamples[i].Position = FVector{ XY[i].X, XY[i].Y, BaseZ };
+    }
+
+    constexpr int32 Lanes = 4;
+    constexpr int32 WaveChunkSize = 16;
+    FWaveLanes waveLanes[WaveChunkSize];
+    alignas(16) float localX[Lanes];
+    alignas(16) float localY[Lanes];
+    alignas(16) float heights[Lanes];
+
+    for (int32 firstWave = 0; firstWave < numWaves; firstWave += WaveChunkSize)
+    {
+        const int32 chunkWaves = FMath::Min(WaveChunkSize, numWaves - firstWave);
+        for (int32 chunkWave = 0; chunkWave < chunkWaves; ++chunkWave)
+        {
+            const int32 i = firstWave + chunkWave;
+            const double kDirX = static_cast<double>(WaveSet.K[i]) * WaveSet.DirX[i];
+            const double kDirY = static_cast<double>(WaveSet.K[i]) * WaveSet.DirY[i];
+            const double anchorPhase = FMath::Fmod(kDirX * anchor.X + kDirY * anchor.Y + static_cast<double>(WaveSet.Omega[i]) * time, 2.0 * UE_DOUBLE_PI);
+            waveLanes[chunkWave] = { VectorSetFloat1(static_cast<float>(kDirX)), VectorSetFloat1(static_cast<float>(kDirY)),
+                VectorSetFloat1(static_cast<float>(anchorPhase)), VectorSetFloat1(WaveSet.Amplitude[i]) };
+        }
+
+        for (int32 first = 0; first < XY.Num(); first += Lanes)
+        {
+            const int32 count = FMath::Min(Lanes, XY.Num() - first);
+            //Pad the last block with its final point so every lane holds a valid position
+            for (int32 lane = 0; lane < Lanes; ++lane)
+            {
+                const int32 index = first + FMath::Min(lane, count - 1);
+                localX[lane] = static_cast<float>(XY[index].X - Origin2D.X - anchor.X);
+                localY[lane] = static_cast<float>(XY[index].Y - Origin2D.Y - anchor.Y);
+                heights[lane] = static_cast<float>(OutSamples[index].Position.Z);
+            }
+            const VectorRegister4Float x = VectorLoadAligned(localX);
+            const VectorRegister4Float y = VectorLoadAligned(localY);
+            VectorRegister4Float z = VectorLoadAligned(heights);
+            for (int32 chunkWave = 0; chunkWave < chunkWaves; ++chunkWave)
+            {
+                const FWaveLanes& wave = waveLanes[chunkWave];
+                VectorRegister4Float phase = VectorMultiplyAdd(x, wave.KDirX, wave.PhaseOffset);
+                phase = VectorMultiplyAdd(y, wave.KDirY, phase);
+                z = VectorMultiplyAdd(wave.Amplitude, VectorSin(phase), z);
+            }
+            VectorStoreAligned(z, heights);
+            for (int32 lane = 0; lane < count; ++lane)
+            {
+                OutSamples[first + lane].Position.Z = heights[lane];
+            }
+        }
+    }
+
+    for (int32 i = 0; i < XY.Num(); ++i)
+    {
+        FWaterSample& waterSample = OutSamples[i];
+        if (!IsInsideGrid(XY[i].X - Origin2D.X, XY[i].Y - Origin2D.Y))
+        {
+            waterSample = { FVector{},FVector{},false };
+            continue;
+        }
+        waterSample.Normal = FVector::UpVector;
+        waterSample.IsValid = true;
+    }
 }
\ No newline at end of file
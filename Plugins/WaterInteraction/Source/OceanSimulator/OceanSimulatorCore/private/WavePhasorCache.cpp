@@ -0,0 +1,156 @@
+#pragma once
+#include "WavePhasorCache.h"
+
+namespace
+{
+    // Float rounding grows the phasor length by about 1e-7 per step, this keeps it well below visible
+    constexpr int32 RenormalizeInterval = 32;
+}
+
+/// <summary>
+/// Stores the waves and seeds the phasor of every wave at every point for the given time.
+/// </summary>
+/// <param name="waveSet"></param>
+/// <param name="localXY"></param>
+/// <param name="time"></param>
+void WavePhasorCache::Initialize(const CompiledWaveSet& waveSet, TArrayView<const FVector2D> localXY, float time)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(WavePhasorCache::Initialize);
+    Waves = waveSet;
+    WaveRevision = waveSet.Revision;
+    NumPoints = localXY.Num();
+    Time = time;
+    StepsSinceRenormalize = 0;
+    bRenormalizeThisStep = false;
+
+    const int32 numWaves = Waves.Num();
+    PhasorRe.SetNumUninitialized(numWaves * NumPoints);
+    PhasorIm.SetNumUninitialized(numWaves * NumPoints);
+    RotorRe.Init(1.0f, numWaves);
+    RotorIm.Init(0.0f, numWaves);
+    for (int32 w = 0; w < numWaves; ++w)
+    {
+        // Wrapped in double precision so points far from the water origin are seeded as accurately as the ones near it
+        const double kDirX = static_cast<double>(Waves.K[w]) * Waves.DirX[w];
+        const double kDirY = static_cast<double>(Waves.K[w]) * Waves.DirY[w];
+        const double timePhase = static_cast<double>(Waves.Omega[w]) * time;
+        float* re = &PhasorRe[w * NumPoints];
+        float* im = &PhasorIm[w * NumPoints];
+        for (int32 p = 0; p < NumPoints; ++p)
+        {
+            const double phase = FMath::Fmod(kDirX * localXY[p].X + kDirY * localXY[p].Y + timePhase, 2.0 * UE_DOUBLE_PI);
+            FMath::SinCos(&im[p], &re[p], static_cast<float>(phase));
+        }
+    }
+}
+
+/// <summary>
+/// Shifting every point by the same offset adds k * dot(D, offset) to the phase of a wave everywhere.
+/// </summary>
+/// <param name="offset"></param>
+void WavePhasorCache::Translate(const FVector2D& offset)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(WavePhasorCache::Translate);
+    for (int32 w = 0; w < Waves.Num(); ++w)
+    {
+        float s, c;
+        const double phase = static_cast<double>(Waves.K[w]) * (Waves.DirX[w] * offset.X + Waves.DirY[w] * offset.Y);
+        FMath::SinCos(&s, &c, static_cast<float>(FMath::Fmod(phase, 2.0 * UE_DOUBLE_PI)));
+        float* re = &PhasorRe[w * NumPoints];
+        float* im = &PhasorIm[w * NumPoints];
+        for (int32 p = 0; p < NumPoints; ++p)
+        {
+            const float rotatedRe = re[p] * c - im[p] * s;
+            im[p] = re[p] * s + im[p] * c;
+            re[p] = rotatedRe;
+        }
+    }
+}
+
+void WavePhasorCache::BeginStep(float time)
+{
+    // Only the time difference goes into the rotation, so it stays accurate however long the game has been running
+    const float deltaTime = time - Time;
+    Time = time;
+    for (int32 w = 0; w < Waves.Num(); ++w)
+    {
+        FMath::SinCos(&RotorIm[w], &RotorRe[w], Waves.Omega[w] * deltaTime);
+    }
+    bRenormalizeThisStep = ++StepsSinceRenormalize >= RenormalizeInterval;
+    if (bRenormalizeThisStep)
+    {
+        StepsSinceRenormalize = 0;
+    }
+}
+
+/// <summary>
+/// Rotates a range of phasors and sums the waves in the same pass. cos(phase) and sin(phase) are the real and imaginary
+/// parts of the phasor, the height and tangents are the same sums as the scalar sampler and ComputeGerstnerNormals.
+/// </summary>
+/// <param name="first"></param>
+/// <param name="count"></param>
+/// <param name="numWaves"></param>
+/// <param name="OutHeights"></param>
+/// <param name="OutNormals"></param>
+void WavePhasorCache::StepPoints(int32 first, int32 count, int32 numWaves, TArrayView<float> OutHeights, TArrayView<FVector> OutNormals)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(WavePhasorCache::StepPoints);
+    check(first >= 0 && first + count <= NumPoints);
+    check(numWaves <= Waves.Num());
+    check(OutHeights.Num() >= count && OutNormals.Num() >= count);
+
+    constexpr int32 BlockSize = 64;
+    float height[BlockSize];
+    float dPx_x[BlockSize], dPx_y[BlockSize], dPx_z[BlockSize];
+    float dPz_x[BlockSize], dPz_y[BlockSize], dPz_z[BlockSize];
+    for (int32 blockStart = 0; blockStart < count; blockStart += BlockSize)
+    {
+        const int32 blockCount = FMath::Min(BlockSize, count - blockStart);
+        for (int32 i = 0; i < blockCount; ++i)
+        {
+            height[i] = 0.0f;
+            dPx_x[i] = 1.0f; dPx_y[i] = 0.0f; dPx_z[i] = 0.0f;
+            dPz_x[i] = 0.0f; dPz_y[i] = 1.0f; dPz_z[i] = 0.0f;
+        }
+
+        for (int32 w = 0; w < numWaves; ++w)
+        {
+            const float rotorRe = RotorRe[w];
+            const float rotorIm = RotorIm[w];
+            const float A = Waves.Amplitude[w];
+            const float Dx = Waves.DirX[w];
+            const float Dy = Waves.DirY[w];
+            const float QAk = Waves.Qi[w] * A * Waves.K[w];
+            const float Ak = A * Waves.K[w];
+            float* re = &PhasorRe[w * NumPoints + first + blockStart];
+            float* im = &PhasorIm[w * NumPoints + first + blockStart];
+            for (int32 i = 0; i < blockCount; ++i)
+            {
+                float c = re[i] * rotorRe - im[i] * rotorIm;
+                float s = re[i] * rotorIm + im[i] * rotorRe;
+                if (bRenormalizeThisStep)
+                {
+                    const float invLength = FMath::InvSqrt(c * c + s * s);
+                    c *= invLength;
+                    s *= invLength;
+                }
+                re[i] = c;
+                im[i] = s;
+
+                height[i] += A * s;
+                dPx_x[i] -= QAk * Dx * Dx * s;
+                dPx_y[i] -= QAk * Dy * Dx * s;
+                dPx_z[i] += Ak * Dx * c;
+                dPz_x[i] -= QAk * Dx * Dy * s;
+                dPz_y[i] -= QAk * Dy * Dy * s;
+                dPz_z[i] += Ak * Dy * c;
+            }
+        }
+
+        for (int32 i = 0; i < blockCount; ++i)
+        {
+            OutHeights[blockStart + i] = height[i];
+            OutNormals[blockStart + i] = (FVector(dPx_x[i], dPx_y[i], dPx_z[i]) ^ FVector(dPz_x[i], dPz_y[i], dPz_z[i])).GetSafeNormal();
+        }
+    }
+}
\ No newline at end of file
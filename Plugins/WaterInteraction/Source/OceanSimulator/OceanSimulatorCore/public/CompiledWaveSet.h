@@ -0,0 +1,24 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "WaveInfo.h"
+
+// Per wave constants derived from the WaveInfo list, kept as parallel arrays so the samplers only stream what they use.
+// Build it once when the waves change, every sampler reads from it instead of recomputing the constants per call.
+// The waves are sorted by decreasing amplitude, so summing only the first n waves is off by at most RemainingAmplitude[n].
+struct OCEANSIMULATORCORE_API CompiledWaveSet
+{
+    TArray<float> K;         // Wave number, 2*PI / Wavelength
+    TArray<float> Omega;     // Angular speed, Speed * K
+    TArray<float> Amplitude;
+    TArray<float> DirX;      // Normalized direction of travel
+    TArray<float> DirY;
+    TArray<float> Qi;        // Gerstner steepness, clamped to [0,1]
+    FVector WaterVelocity = FVector::ZeroVector; // Sum of the wave velocities in m/s
+    TArray<float> RemainingAmplitude; // Sum of the amplitudes from wave i to the end, Num() + 1 entries ending in 0
+    uint32 Revision = 0;     // Bumped by every Build, lets caches derived from the waves notice they are stale
+
+    void Build(const TArray<WaveInfo>& waves);
+    int32 Num() const { return K.Num(); }
+    // Fewest leading waves whose height differs from the full sum by at most tolerance, all of them when tolerance <= 0
+    int32 NumWavesForTolerance(float tolerance) const;
+};
\ No newline at end of file
@@ -0,0 +1,78 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "WaterSurface.h"
+#include <atomic>
+
+// Parameters of the wave spectrum the heightfield is synthesized from
+struct SpectrumSettings
+{
+    int32 Resolution = 256;         // Samples along each side, rounded to a power of two in [16, 1024]
+    float PatchSize = 50000.0f;     // cm covered by the heightfield before it repeats
+    float WindSpeed = 10.0f;        // m/s
+    FVector2D WindDirection{ 1, 0 };
+    float Amplitude = 1.0f;         // Multiplier on the fully developed sea height for the wind speed
+    float Choppiness = 1.0f;        // Scale of the horizontal displacement
+    float SmallWaveCutoff = 10.0f;  // cm, waves much shorter than this are suppressed
+    int32 Seed = 1;
+};
+
+// Water surface synthesized from a Phillips spectrum with a CPU FFT.
+// Every frequency of the Resolution x Resolution grid contributes, so the cost of a query does not grow with the number of waves.
+// The heightfield tiles every PatchSize and point queries are bilinear lookups into the last published field,
+// the time passed to the queries is ignored. Queries return the height of the displaced surface at the queried XY.
+// Synthesize can run on a worker thread while the samplers read, it writes into a field that is neither the
+// published one nor the one published before it, so readers that started one update ago are still safe.
+class OCEANSIMULATORCORE_API SpectrumWaterSurfaceCore : public IWaterSurface
+{
+public:
+    SpectrumWaterSurfaceCore() = default;
+    virtual ~SpectrumWaterSurfaceCore() = default;
+
+    // Builds the initial spectrum, must be called before anything else
+    void InitializeSpectrum(const SpectrumSettings& settings, FVector2D origin2D, float baseZ);
+    // Evolves the spectrum to the given time and transforms it into the write field
+    void Synthesize(float time);
+    // Makes the last synthesized field visible to the samplers. Call on the game thread once Synthesize is done.
+    void PublishSynthesized();
+
+    virtual FWaterSample SampleHeightAt(const FVector2D& XY, float time) const override;
+    virtual void SampleHeights(TArrayView<const FVector2D> XY, float time, TArrayView<FWaterSample> OutSamples) const override;
+    virtual FVector GetWaterVelocity() const override;
+    virtual FFloatInterval GetHeightBounds(const FBox2D& region, float time) const override;
+private:
+    struct Field
+    {
+        TArray<float> Height;
+        TArray<float> DisplacementX;
+        TArray<float> DisplacementY;
+        float MinHeight = 0.0f;
+        float MaxHeight = 0.0f;
+        float MaxDisplacement = 0.0f; // Largest sideways move of any lattice point along either axis
+    };
+    // Four grid points around a lattice position and the bilinear weights between them
+    struct FieldLookup
+    {
+        int32 I00, I10, I01, I11;
+        float TX, TY;
+    };
+    FieldLookup LookupField(const FVector2D& XY) const;
+    FWaterSample SampleField(const Field& field, const FVector2D& XY) const;
+
+    SpectrumSettings Settings;
+    FVector2D Origin2D = FVector2D::ZeroVector;
+    float BaseZ = 0.0f;
+    int32 N = 0;
+    float CellSize = 0.0f;
+
+    // Initial amplitudes h0(k) and conj(h0(-k)), plus the wave vector and dispersion per frequency
+    TArray<float> H0Re, H0Im, H0MinusConjRe, H0MinusConjIm;
+    TArray<float> KX, KY, InvK, Omega;
+    TArray<float> TwiddleRe, TwiddleIm;
+    TArray<int32> BitReverse;
+    TArray<float> SpectrumARe, SpectrumAIm, SpectrumBRe, SpectrumBIm; // Scratch, only touched by Synthesize
+
+    Field Fields[3];
+    std::atomic<int32> FrontField{ 0 };
+    int32 PreviousField = 1;
+    int32 WriteField = 2;
+};
\ No newline at end of file
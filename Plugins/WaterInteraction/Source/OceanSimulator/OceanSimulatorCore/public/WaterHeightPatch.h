@@ -0,0 +1,34 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "WaterSurface.h"
+
+// A small grid of heights evaluated once over a region of another water surface.
+// Queries inside the region are bilinear lookups into the grid, queries outside of it are forwarded to the source surface.
+// The grid is a snapshot at the time of the last Refresh, the time passed to the queries is only used for the fallback.
+class OCEANSIMULATORCORE_API WaterHeightPatch : public IWaterSurface
+{
+public:
+    WaterHeightPatch() = default;
+    virtual ~WaterHeightPatch() = default;
+
+    // Re-evaluates the grid over bounds. Resolution is the number of samples along each side.
+    void Refresh(const IWaterSurface* source, const FBox2D& bounds, int32 resolution, float time);
+
+    virtual FWaterSample SampleHeightAt(const FVector2D& XY, float time) const override;
+    virtual void SampleHeights(TArrayView<const FVector2D> XY, float time, TArrayView<FWaterSample> OutSamples) const override;
+    virtual FVector GetWaterVelocity() const override;
+    // Range of the grid heights over the region, parts of the region the grid doesn't cover are bounded by the source
+    virtual FFloatInterval GetHeightBounds(const FBox2D& region, float time) const override;
+private:
+    bool Lookup(const FVector2D& XY, FWaterSample& outSample) const;
+
+    const IWaterSurface* Source = nullptr; //Does not own the surface
+    FVector2D PatchOrigin = FVector2D::ZeroVector;
+    FVector2D CellSize = FVector2D::ZeroVector;
+    FVector2D InvCellSize = FVector2D::ZeroVector;
+    int32 Resolution = 0;
+    TArray<float> Heights; // Resolution x Resolution, row major
+    TArray<bool> Valid;    // False where the source could not be sampled
+    TArray<FVector2D> SamplePoints; // Kept between refreshes to avoid reallocating every tick
+    TArray<FWaterSample> Samples;
+};
\ No newline at end of file
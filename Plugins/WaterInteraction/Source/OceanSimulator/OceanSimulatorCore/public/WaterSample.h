@@ -7,4 +7,11 @@ struct FWaterSample
     FVector Position; // Global Position
     FVector Normal;   //Global Normal
     bool IsValid;
+};
+
+struct FWaterRayHit
+{
+    FVector Position; // Global Position
+    FVector Normal;   // Global Normal
+    float Distance;   // Along the ray from its origin
 };
\ No newline at end of file
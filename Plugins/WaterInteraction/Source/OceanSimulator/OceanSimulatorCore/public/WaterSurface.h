@@ -1,13 +1,42 @@
 #pragma once
 #include "CoreMinimal.h"
+#include "Math/Interval.h"
 #include "WaterSample.h"
 #include "WaveInfo.h"
+#include "CompiledWaveSet.h"
 
-class IWaterSurface
+class OCEANSIMULATORCORE_API IWaterSurface
 {
 public:
     virtual FWaterSample SampleHeightAt(const FVector2D& XY, float time) const = 0;
+    /// Samples the surface at many points in one call. OutSamples must be at least as long as XY.
+    /// The default implementation falls back to SampleHeightAt per point, surfaces with a faster path should override it.
+    virtual void SampleHeights(TArrayView<const FVector2D> XY, float time, TArrayView<FWaterSample> OutSamples) const
+    {
+        check(OutSamples.Num() >= XY.Num());
+        for (int32 i = 0; i < XY.Num(); ++i)
+        {
+            OutSamples[i] = SampleHeightAt(XY[i], time);
+        }
+    }
+    /// Same as SampleHeights, but the heights may be off by up to maxError so the surface can skip detail the caller can't use,
+    /// e.g. a coarse mesh ring or a small piece of debris. The default implementation is exact.
+    virtual void SampleHeightsApprox(TArrayView<const FVector2D> XY, float time, float maxError, TArrayView<FWaterSample> OutSamples) const
+    {
+        SampleHeights(XY, time, OutSamples);
+    }
     virtual FVector GetWaterVelocity() const = 0;
+    /// Range of heights any sample inside region can return at this time, so callers can skip sampling where the answer can't matter.
+    /// The range is conservative but should be as tight as the surface can make it cheaply. An empty interval means there is no water
+    /// in the region. The default implementation knows nothing about the surface and returns the whole float range.
+    virtual FFloatInterval GetHeightBounds(const FBox2D& region, float time) const
+    {
+        return FFloatInterval(TNumericLimits<float>::Lowest(), TNumericLimits<float>::Max());
+    }
+    /// Finds where the ray first crosses the surface, from above or from below. Direction must be normalized.
+    /// The default implementation brackets the crossing by marching through batched samples and refines it by bisection,
+    /// features shorter than maxDistance / 64 along the ray can be stepped over.
+    virtual bool Raycast(const FVector& origin, const FVector& direction, float maxDistance, float time, FWaterRayHit& outHit) const;
 protected:
     virtual ~IWaterSurface() = default; // Ensure proper cleanup of derived classes
 };
@@ -17,20 +46,38 @@ class OCEANSIMULATORCORE_API WaterSurfaceCore  : public IWaterSurface
 {
 public:
     WaterSurfaceCore() = default; // Default constructor
-    WaterSurfaceCore(TArray<WaveInfo>& waves, float gridSize, float gridWorldSize,FVector2D origin2D, float baseZ)
-        : Waves(waves), GridSize(gridSize), GridWorldSize(gridWorldSize), Origin2D(origin2D), BaseZ(baseZ) 
+    WaterSurfaceCore(const TArray<WaveInfo>& waves, float gridSize, float gridWorldSize,FVector2D origin2D, float baseZ)
+        : GridSize(gridSize), GridWorldSize(gridWorldSize), Origin2D(origin2D), BaseZ(baseZ) 
     {
+        SetWaves(waves);
     }
     virtual FWaterSample SampleHeightAt(const FVector2D& XY, float time) const override;
+    virtual void SampleHeights(TArrayView<const FVector2D> XY, float time, TArrayView<FWaterSample> OutSamples) const override;
+    virtual void SampleHeightsApprox(TArrayView<const FVector2D> XY, float time, float maxError, TArrayView<FWaterSample> OutSamples) const override;
     virtual FVector GetWaterVelocity() const override;
+    virtual FFloatInterval GetHeightBounds(const FBox2D& region, float time) const override;
+
+    // Replaces the wave list and rebuilds the compiled wave set. This is the only way the waves should be edited.
+    void SetWaves(const TArray<WaveInfo>& waves);
+    const TArray<WaveInfo>& GetWaves() const { return Waves; }
+    const CompiledWaveSet& GetCompiledWaves() const { return WaveSet; }
 public:
-    TArray<WaveInfo> Waves;
     float GridSize;
     float GridWorldSize;
     FVector2D Origin2D; // The origin of the grid in world coordinates
     float BaseZ; // The base Z coordinate for the water surface
+    bool bUnbounded = false; // Sample the waves everywhere instead of only inside [Origin2D, Origin2D + GridWorldSize]
     virtual ~WaterSurfaceCore() = default; // Ensure proper cleanup of derived classes
+protected:
+    bool IsInsideGrid(double localX, double localY) const
+    {
+        return bUnbounded || (localX >= 0 && localX <= GridWorldSize && localY >= 0 && localY <= GridWorldSize);
+    }
+
 private:
-    mutable TOptional<FVector> WaterVelocity;
+    void SampleLeadingWaves(TArrayView<const FVector2D> XY, float time, int32 numWaves, TArrayView<FWaterSample> OutSamples) const;
+
+    TArray<WaveInfo> Waves;
+    CompiledWaveSet WaveSet; // Derived from Waves, rebuilt in SetWaves
 
 };
\ No newline at end of file
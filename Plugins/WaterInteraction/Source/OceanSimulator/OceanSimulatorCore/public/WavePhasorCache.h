@@ -0,0 +1,39 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "CompiledWaveSet.h"
+
+// Caches exp(i * phase) of every wave at a fixed set of points, for surfaces that are evaluated at the same points every tick.
+// The spatial part of the phase never changes, so advancing in time is one complex multiply per wave and point
+// instead of a sin and a cos. The phasors are renormalized every few steps so the rounding error can't grow their length.
+// Points are in the local space of the water, the same as the one the Gerstner sampler uses.
+class OCEANSIMULATORCORE_API WavePhasorCache
+{
+public:
+    // Seeds the phasors exactly, this is the only place that calls sin/cos per point
+    void Initialize(const CompiledWaveSet& waveSet, TArrayView<const FVector2D> localXY, float time);
+    // Moves every point by the same offset, one rotation per wave
+    void Translate(const FVector2D& offset);
+    // Computes the rotation of every wave from the cached time to the new one. Call once before the StepPoints calls of a tick.
+    void BeginStep(float time);
+    // Rotates the points [first, first + count) to the time given to BeginStep and evaluates the Gerstner height and normal there.
+    // Heights are relative to the base of the water. Disjoint ranges can be stepped in parallel.
+    // Only the first numWaves waves are advanced and summed, a point must always be stepped with the same count
+    // until the cache is initialized again, or the waves it skipped fall out of step.
+    void StepPoints(int32 first, int32 count, int32 numWaves, TArrayView<float> OutHeights, TArrayView<FVector> OutNormals);
+
+    bool IsValidFor(const CompiledWaveSet& waveSet, int32 numPoints) const { return WaveRevision == waveSet.Revision && NumPoints == numPoints && NumPoints > 0; }
+    float GetTime() const { return Time; }
+private:
+    CompiledWaveSet Waves;
+    uint32 WaveRevision = 0;
+    int32 NumPoints = 0;
+    float Time = 0.0f;
+    // Wave major, the phasor of wave w at point p is at w * NumPoints + p
+    TArray<float> PhasorRe;
+    TArray<float> PhasorIm;
+    // Rotation of the current step per wave
+    TArray<float> RotorRe;
+    TArray<float> RotorIm;
+    int32 StepsSinceRenormalize = 0;
+    bool bRenormalizeThisStep = false;
+};
\ No newline at end of file
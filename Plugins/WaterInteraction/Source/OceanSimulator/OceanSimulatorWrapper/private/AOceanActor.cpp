@@ -1,4 +1,5 @@
 #include "AOceanActor.h"
+#include "FFTOceanComponent.h"
 
 AOceanActor::AOceanActor()
 {
@@ -14,6 +15,22 @@ void AOceanActor::BeginPlay()
 {
     Super::BeginPlay();
     TRACE_BOOKMARK(TEXT("AOceanActor::BeginPlay"));
+
+    if (UFFTOceanComponent* fftOcean = FindComponentByClass<UFFTOceanComponent>())
+    {
+        // The mesh follows the spectrum, and is displaced after the field of the frame is published
+        GerstnerWaveComponent->SetMeshHeightSource(fftOcean);
+        GerstnerWaveComponent->PrimaryComponentTick.AddPrerequisite(fftOcean, fftOcean->PrimaryComponentTick);
+    }
+}
+
+IWaterSurface* AOceanActor::GetWaterSurface() const
+{
+    if (UFFTOceanComponent* fftOcean = FindComponentByClass<UFFTOceanComponent>())
+    {
+        return fftOcean;
+    }
+    return GerstnerWaveComponent;
 }
 
 void AOceanActor::Tick(float DeltaTime)
@@ -21,3 +38,21 @@ void AOceanActor::Tick(float DeltaTime)
     Super::Tick(DeltaTime);
     TRACE_CPUPROFILER_EVENT_SCOPE(AOceanActor::Tick);
 }
+
+
+bool AOceanActor::TraceWater(const FVector& Start, const FVector& End, FVector& HitLocation, FVector& HitNormal) const
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(AOceanActor::TraceWater);
+    const IWaterSurface* waterSurface = GetWaterSurface();
+    FVector direction;
+    double length;
+    (End - Start).ToDirectionAndLength(direction, length);
+    FWaterRayHit hit;
+    if (waterSurface == nullptr || !waterSurface->Raycast(Start, direction, static_cast<float>(length), GetWorld()->GetTimeSeconds(), hit))
+    {
+        return false;
+    }
+    HitLocation = hit.Position;
+    HitNormal = hit.Normal;
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "FFTOceanComponent.h"
+#include "Engine/World.h"
+
+UFFTOceanComponent::UFFTOceanComponent() : Super()
+{
+    PrimaryComponentTick.bCanEverTick = true;
+}
+
+void UFFTOceanComponent::BeginPlay()
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(UFFTOceanComponent::BeginPlay);
+    Super::BeginPlay();
+
+    SpectrumSettings settings;
+    settings.Resolution = Resolution;
+    settings.PatchSize = PatchSize;
+    settings.WindSpeed = WindSpeed;
+    settings.WindDirection = WindDirection;
+    settings.Amplitude = Amplitude;
+    settings.Choppiness = Choppiness;
+    settings.SmallWaveCutoff = SmallWaveCutoff;
+    settings.Seed = Seed;
+    const FVector location = GetOwner()->GetActorLocation();
+    InitializeSpectrum(settings, FVector2D(location.X, location.Y), location.Z);
+}
+
+/// <summary>
+/// Publishes the field synthesized during the previous frame and starts on the next one.
+/// </summary>
+/// <param name="DeltaTime"></param>
+/// <param name="TickType"></param>
+/// <param name="ThisTickFunction"></param>
+void UFFTOceanComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(UFFTOceanComponent::TickComponent);
+    Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+    if (SynthesizeTask.IsValid())
+    {
+        SynthesizeTask.Wait();
+        PublishSynthesized();
+    }
+
+    // The field is published next frame, so synthesize it for the time it will be used at
+    const float synthesizeTime = GetWorld()->GetTimeSeconds() + DeltaTime;
+    SynthesizeTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, [this, synthesizeTime]
+        {
+            Synthesize(synthesizeTime);
+        });
+}
+
+void UFFTOceanComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    if (SynthesizeTask.IsValid())
+    {
+        SynthesizeTask.Wait();
+    }
+    Super::EndPlay(EndPlayReason);
+}
\ No newline at end of file
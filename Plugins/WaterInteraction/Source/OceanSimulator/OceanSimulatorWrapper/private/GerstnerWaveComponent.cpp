@@ -7,9 +7,14 @@
 #include "Materials/MaterialParameterCollectionInstance.h"
 #include "Materials/MaterialParameterCollection.h"
 #include "Materials/Material.h"
+#include "Async/ParallelFor.h"
+#include "GameFramework/PlayerController.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
 
 UGerstnerWaveComponent::UGerstnerWaveComponent() : Super()
-, WaterSurfaceCore(Waves, GridSize, GridWorldSize, FVector2D::ZeroVector, 0.0f)
+, WaterSurfaceCore(TArray<WaveInfo>{}, GridSize, GridWorldSize, FVector2D::ZeroVector, 0.0f)
 {
     // Enable ticking if you need per-frame updates for your simulation
     PrimaryComponentTick.bCanEverTick = true;
@@ -64,7 +69,8 @@ void UGerstnerWaveComponent::BeginPlay()
     bool result = materialParametersinstance->GetScalarParameterValue(FName("WavesCount"), waveCount);
     ensure(result == true);
     ensure(waveCount > 0);
-    Waves.SetNum(static_cast<int32_t>(waveCount));
+    TArray<WaveInfo> waves;
+    waves.SetNum(static_cast<int32_t>(waveCount));
 
     for (int i = 0; i < waveCount; ++i)
     {
@@ -84,86 +90,82 @@ void UGerstnerWaveComponent::BeginPlay()
 
         result = materialParametersinstance->GetVectorParameterValue(FName{ *(Prefix + "Direction") }, direction);
         ensure(result == true);
-        Waves[i].Amplitude = waveAmplitude;
-        Waves[i].Wavelength = waveLength;
-        Waves[i].Speed = speed;
-        Waves[i].Steepness = steepness;
-        Waves[i].Direction = FVector2D{ direction.R,direction.G };
+        waves[i].Amplitude = waveAmplitude;
+        waves[i].Wavelength = waveLength;
+        waves[i].Speed = speed;
+        waves[i].Steepness = steepness;
+        waves[i].Direction = FVector2D{ direction.R,direction.G };
     }
+    SetWaves(waves); // Compiles the per wave constants used by all the samplers
 
     // Push the data to the core part
     WaterSurfaceCore::GridSize = GridSize;
     WaterSurfaceCore::GridWorldSize = GridWorldSize;
     WaterSurfaceCore::Origin2D = FVector2D(GetOwner()->GetActorLocation().X, GetOwner()->GetActorLocation().Y);
     WaterSurfaceCore::BaseZ = GetOwner()->GetActorLocation().Z;
+    WaterSurfaceCore::bUnbounded = bUnboundedWater;
+
+    if (bUseInstancedTiles)
+    {
+        CreateTiles();
+    }
 }
 
 
 /// <summary>
 /// This function returns one normal per vertex, using the GPU Gems Gerstner normal formula.
+/// The per wave constants are read from the compiled wave set so they match the physics sampler.
+/// Writes into OutNormals so that it can fill a chunk of a preallocated buffer.
 /// </summary>
 /// <param name="OriginalVerts"></param>
-/// <param name="Waves"></param>
+/// <param name="VertexOffset">Added to every vertex, used by the clipmap to move the rings</param>
+/// <param name="WaveSet"></param>
+/// <param name="NumWaves">Only the first NumWaves waves, the largest ones, are summed</param>
 /// <param name="Time"></param>
-/// <returns></returns>
-TArray<FVector> ComputeGerstnerNormals(
-    const TArray<FVector>& OriginalVerts,
-    const TArray<WaveInfo>& Waves,
-    float Time)
+/// <param name="OutNormals"></param>
+void ComputeGerstnerNormals(
+    TArrayView<const FVector> OriginalVerts,
+    const FVector2D& VertexOffset,
+    const CompiledWaveSet& WaveSet,
+    int32 NumWaves,
+    float Time,
+    TArrayView<FVector> OutNormals)
 {
     TRACE_CPUPROFILER_EVENT_SCOPE(ComputeGerstnerNormals);
 
-    const float g = 980.f;// gravity
     int32 NumVerts = OriginalVerts.Num();
-
-    TArray<FVector> OutNormals;
-    OutNormals.SetNum(NumVerts);
-
-    // Precompute for each wave
-    struct FPre
-    {
-        float k, omega, Qi, A;
-        FVector2D D;
-    };
-    TArray<FPre> Pre;
-    Pre.Reserve(Waves.Num());
-
-    float MasterSteepness = 1.0f;
-    for (const WaveInfo& w : Waves)
-    {
-        float ki = 2.f * PI / w.Wavelength;
-        float Ai = w.Amplitude;
-        float omega = FMath::Sqrt(g * ki);
-        float Qi = MasterSteepness / (ki * Ai * Waves.Num());
-        Qi = FMath::Clamp(Qi, 0.f, 1.f);
-
-        Pre.Add({ ki, omega, Qi, Ai, w.Direction.GetSafeNormal() });
-    }
+    check(OutNormals.Num() >= NumVerts);
 
     // Compute normal at each vertex
     for (int32 i = 0; i < NumVerts; ++i)
     {
         const FVector& P0 = OriginalVerts[i];   // (x0, y0, 0)
-        float x0 = P0.X, y0 = P0.Y;
+        float x0 = P0.X + VertexOffset.X, y0 = P0.Y + VertexOffset.Y;
 
         float dPx_x = 1.f, dPx_y = 0.f, dPx_z = 0.f;
         float dPz_x = 0.f, dPz_y = 1.f, dPz_z = 0.f;
 
         // Sum contributions from every wave
-        for (const FPre& p : Pre)
+        for (int32 w = 0; w < NumWaves; ++w)
         {
-            float dot = p.D.X * x0 + p.D.Y * y0;
-            float phase = p.k * dot - p.omega * Time;
+            const float k = WaveSet.K[w];
+            const float A = WaveSet.Amplitude[w];
+            const float Dx = WaveSet.DirX[w];
+            const float Dy = WaveSet.DirY[w];
+            const float QAk = WaveSet.Qi[w] * A * k;
+
+            float dot = Dx * x0 + Dy * y0;
+            float phase = k * dot + WaveSet.Omega[w] * Time;
             float c = FMath::Cos(phase);
             float s = FMath::Sin(phase);
 
-            float dDX_dx = -p.Qi * p.A * p.k * p.D.X * p.D.X * s;
-            float dDX_dz = -p.Qi * p.A * p.k * p.D.X * p.D.Y * s;
-            float dDY_dx = -p.Qi * p.A * p.k * p.D.Y * p.D.X * s;
-            float dDY_dz = -p.Qi * p.A * p.k * p.D.Y * p.D.Y * s;
+            float dDX_dx = -QAk * Dx * Dx * s;
+            float dDX_dz = -QAk * Dx * Dy * s;
+            float dDY_dx = -QAk * Dy * Dx * s;
+            float dDY_dz = -QAk * Dy * Dy * s;
 
-            float dDZ_dx = p.A * p.k * p.D.X * c;
-            float dDZ_dz = p.A * p.k * p.D.Y * c;
+            float dDZ_dx = A * k * Dx * c;
+            float dDZ_dz = A * k * Dy * c;
 
             dPx_x += dDX_dx;
             dPx_y += dDY_dx;
@@ -180,8 +182,6 @@ TArray<FVector> ComputeGerstnerNormals(
         // Crossproduct -> normal, then normalize
         OutNormals[i] = (TangentX ^ TangentZ).GetSafeNormal();
     }
-
-    return OutNormals;
 }
 
 /// <summary>
@@ -190,60 +190,70 @@ TArray<FVector> ComputeGerstnerNormals(
 void UGerstnerWaveComponent::GenerateGrid()
 {
     TRACE_BOOKMARK(TEXT("UGerstnerWaveComponent::GenerateGrid"));
-    // Build flat grid
-    OriginalVerts.Empty();
-    HeightMap.SetNum(GridSize);
-    for (int i = 0; i < GridSize; ++i)
+    const bool useClipmap = bUpdateMeshOnCPU && bUseClipmap;
+    TArray<int32> Triangles;
+    TArray<FVector2D> UVs;
+    if (useClipmap)
     {
-        HeightMap[i].SetNum(GridSize);
+        BuildClipmapLayout(Triangles);
+        UVs.Init(FVector2D::ZeroVector, OriginalVerts.Num()); // Written every update from the world position
     }
-
-    float Step = GridWorldSize / (GridSize - 1);
-    for (int y = 0; y < GridSize; ++y)
+    else
     {
-        for (int x = 0; x < GridSize; ++x)
+        // Build flat grid
+        OriginalVerts.Empty();
+        OriginalVerts.Reserve(GridSize * GridSize);
+
+        float Step = GridWorldSize / (GridSize - 1);
+        for (int y = 0; y < GridSize; ++y)
         {
-            OriginalVerts.Add(FVector(x * Step, y * Step, 0));
-            HeightMap[y][x] = 0.0f;
+            for (int x = 0; x < GridSize; ++x)
+            {
+                OriginalVerts.Add(FVector(x * Step, y * Step, 0));
+            }
         }
-    }
 
-    // Build triangle index list
-    TArray<int32> Triangles;
-    for (int y = 0; y < GridSize - 1; ++y)
-    {
-        for (int x = 0; x < GridSize - 1; ++x)
+        // Build triangle index list
+        for (int y = 0; y < GridSize - 1; ++y)
         {
-            int i = y * GridSize + x;
-            // CCW winding
-            Triangles.Add(i);
-            Triangles.Add(i + GridSize);
-            Triangles.Add(i + 1);
-
-            Triangles.Add(i + 1);
-            Triangles.Add(i + GridSize);
-            Triangles.Add(i + GridSize + 1);
+            for (int x = 0; x < GridSize - 1; ++x)
+            {
+                int i = y * GridSize + x;
+                // CCW winding
+                Triangles.Add(i);
+                Triangles.Add(i + GridSize);
+                Triangles.Add(i + 1);
+
+                Triangles.Add(i + 1);
+                Triangles.Add(i + GridSize);
+                Triangles.Add(i + GridSize + 1);
+            }
         }
+
+        MeshLevelStarts = { 0, OriginalVerts.Num() };
+        MeshLevelOuterStarts = { OriginalVerts.Num() };
+        UVs.Init(FVector2D::ZeroVector, OriginalVerts.Num());
+        for (int y = 0; y < GridSize; ++y)
+            for (int x = 0; x < GridSize; ++x)
+                UVs[y * GridSize + x] = FVector2D((float)x / (GridSize - 1), (float)y / (GridSize - 1));
     }
 
-    // Normals, UVs & Colors
+    // Normals & Colors
     TArray<FVector> Normals;      Normals.Init(FVector(0, 0, 1), OriginalVerts.Num());
-    TArray<FVector2D> UVs;        UVs.Init(FVector2D::ZeroVector, OriginalVerts.Num());
     TArray<FLinearColor> Colors;  Colors.Init(FLinearColor::White, OriginalVerts.Num());
-    for (int y = 0; y < GridSize; ++y)
-        for (int x = 0; x < GridSize; ++x)
-            UVs[y * GridSize + x] = FVector2D((float)x / (GridSize - 1), (float)y / (GridSize - 1));
 
-    NormalMap.SetNum(GridSize);
-    for (int y = 0; y < GridSize; ++y)
+    // Both halves of the double buffer are allocated here once, the tick only overwrites them
+    for (int32 buffer = 0; buffer < 2; ++buffer)
     {
-        NormalMap[y].SetNum(GridSize);
-        for (int x = 0; x < GridSize; ++x)
+        MeshPositions[buffer] = OriginalVerts;
+        MeshNormals[buffer] = Normals;
+        if (useClipmap)
         {
-            NormalMap[y][x] = FVector(0, 0, 1);
+            MeshUVs[buffer] = UVs;
         }
     }
-    ProcMesh->bUseComplexAsSimpleCollision = true;
+    ProcMesh->bUseComplexAsSimpleCollision = bCookCollision;
+    ProcMesh->bUseAsyncCooking = bUpdateMeshOnCPU; // Collision is re-cooked on every mesh update, keep it off the game thread
     // Create mesh section
     ProcMesh->CreateMeshSection_LinearColor(
         0,
@@ -253,23 +263,30 @@ void UGerstnerWaveComponent::GenerateGrid()
         UVs,
         Colors,
         TArray<FProcMeshTangent>(),
-        true
+        bCookCollision
     );
 
-    ProcMesh->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
-    ProcMesh->SetCollisionObjectType(ECC_PhysicsBody);
-    ProcMesh->SetCollisionResponseToAllChannels(ECR_Block);
-    ProcMesh->SetCollisionResponseToChannel(ECC_Visibility, ECR_Block);
-
     ProcMesh->SetSimulatePhysics(false);
-
-    if (!ProcMesh->ContainsPhysicsTriMeshData(true))
+    if (bCookCollision)
     {
-        UE_LOG(LogTemp, Error, TEXT("ProcMesh has NO collision data!"));
+        ProcMesh->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
+        ProcMesh->SetCollisionObjectType(ECC_PhysicsBody);
+        ProcMesh->SetCollisionResponseToAllChannels(ECR_Block);
+        ProcMesh->SetCollisionResponseToChannel(ECC_Visibility, ECR_Block);
+
+        if (!ProcMesh->ContainsPhysicsTriMeshData(true))
+        {
+            UE_LOG(LogTemp, Error, TEXT("ProcMesh has NO collision data!"));
+        }
+        else
+        {
+            UE_LOG(LogTemp, Log, TEXT("ProcMesh collision ready: tris"));
+        }
     }
     else
     {
-        UE_LOG(LogTemp, Log, TEXT("ProcMesh collision ready: tris"));
+        // Queries against the water go through IWaterSurface::Raycast
+        ProcMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
     }
 
     // Assign a basic opaque material
@@ -283,6 +300,211 @@ void UGerstnerWaveComponent::GenerateGrid()
     }
 }
 
+/// <summary>
+/// Builds the clipmap rings into OriginalVerts as offsets from the clipmap center.
+/// Every level is a grid of ClipmapLevelResolution cells with twice the spacing of the level inside it,
+/// levels above 0 leave out the middle half that the finer level already covers.
+/// The outer edge of each level has a vertex in the middle of every edge of the next level, those are
+/// recorded in ClipmapStitches so their height can be blended to close the T-junction cracks.
+/// The outer edge of every level is moved to the end of the level, see MeshLevelOuterStarts, so it can be evaluated with the
+/// waves of the next level, which shares those positions.
+/// </summary>
+/// <param name="Triangles"></param>
+void UGerstnerWaveComponent::BuildClipmapLayout(TArray<int32>& Triangles)
+{
+    const int32 N = Align(FMath::Max(ClipmapLevelResolution, 8), 4);
+    const int32 half = N / 2;
+    OriginalVerts.Empty();
+    ClipmapStitches.Empty();
+    MeshLevelStarts.Empty();
+    MeshLevelOuterStarts.Empty();
+
+    TArray<int32> vertexLookup;
+    for (int32 level = 0; level < ClipmapLevels; ++level)
+    {
+        const float spacing = ClipmapBaseSpacing * (1 << level);
+        const int32 levelStart = OriginalVerts.Num();
+        const int32 levelTrianglesStart = Triangles.Num();
+        MeshLevelStarts.Add(levelStart); // The vertices of a level are added together, see MeshLevelStarts
+        vertexLookup.Init(INDEX_NONE, (N + 1) * (N + 1));
+        auto getVertex = [&](int32 x, int32 y)
+            {
+                int32& index = vertexLookup[y * (N + 1) + x];
+                if (index == INDEX_NONE)
+                {
+                    index = OriginalVerts.Add(FVector((x - half) * spacing, (y - half) * spacing, 0));
+                }
+                return index;
+            };
+
+        for (int32 y = 0; y < N; ++y)
+        {
+            for (int32 x = 0; x < N; ++x)
+            {
+                const bool isInsideFinerLevel = level > 0 && x >= N / 4 && x < 3 * N / 4 && y >= N / 4 && y < 3 * N / 4;
+                if (isInsideFinerLevel)
+                {
+                    continue;
+                }
+                // Same winding as the uniform grid
+                const int32 i00 = getVertex(x, y);
+                const int32 i01 = getVertex(x, y + 1);
+                const int32 i10 = getVertex(x + 1, y);
+                const int32 i11 = getVertex(x + 1, y + 1);
+                Triangles.Add(i00);
+                Triangles.Add(i01);
+                Triangles.Add(i10);
+
+                Triangles.Add(i10);
+                Triangles.Add(i01);
+                Triangles.Add(i11);
+            }
+        }
+
+        // Inner vertices first, then the outer edge
+        TArray<int32> levelRemap;
+        levelRemap.SetNumUninitialized(OriginalVerts.Num() - levelStart);
+        int32 nextIndex = levelStart;
+        for (const bool outerEdge : { false, true })
+        {
+            if (outerEdge)
+            {
+                MeshLevelOuterStarts.Add(nextIndex);
+            }
+            for (int32 y = 0; y <= N; ++y)
+            {
+                for (int32 x = 0; x <= N; ++x)
+                {
+                    const int32 index = vertexLookup[y * (N + 1) + x];
+                    if (index != INDEX_NONE && outerEdge == (x == 0 || x == N || y == 0 || y == N))
+                    {
+                        levelRemap[index - levelStart] = nextIndex++;
+                    }
+                }
+            }
+        }
+        const TArray<FVector> levelVerts(&OriginalVerts[levelStart], levelRemap.Num());
+        for (int32 i = 0; i < levelRemap.Num(); ++i)
+        {
+            OriginalVerts[levelRemap[i]] = levelVerts[i];
+        }
+        for (int32 i = levelTrianglesStart; i < Triangles.Num(); ++i)
+        {
+            Triangles[i] = levelRemap[Triangles[i] - levelStart];
+        }
+        for (int32& index : vertexLookup)
+        {
+            if (index != INDEX_NONE)
+            {
+                index = levelRemap[index - levelStart];
+            }
+        }
+
+        if (level + 1 < ClipmapLevels)
+        {
+            // half is even, so odd indices are the midpoints of the coarser level's edges
+            auto lookup = [&](int32 x, int32 y) { return vertexLookup[y * (N + 1) + x]; };
+            for (int32 i = 1; i < N; i += 2)
+            {
+                ClipmapStitches.Add(FIntVector(lookup(i, 0), lookup(i - 1, 0), lookup(i + 1, 0)));
+                ClipmapStitches.Add(FIntVector(lookup(i, N), lookup(i - 1, N), lookup(i + 1, N)));
+                ClipmapStitches.Add(FIntVector(lookup(0, i), lookup(0, i - 1), lookup(0, i + 1)));
+                ClipmapStitches.Add(FIntVector(lookup(N, i), lookup(N, i - 1), lookup(N, i + 1)));
+            }
+        }
+    }
+    MeshLevelStarts.Add(OriginalVerts.Num());
+}
+
+/// <summary>
+/// World location the clipmap and the tiles follow, the focus actor if set, otherwise the player camera.
+/// </summary>
+/// <returns></returns>
+FVector UGerstnerWaveComponent::GetFocusLocation() const
+{
+    if (ClipmapFocusActor != nullptr)
+    {
+        return ClipmapFocusActor->GetActorLocation();
+    }
+    if (APlayerController* playerController = GetWorld()->GetFirstPlayerController())
+    {
+        if (playerController->PlayerCameraManager != nullptr)
+        {
+            return playerController->PlayerCameraManager->GetCameraLocation();
+        }
+    }
+    return GetOwner()->GetActorLocation();
+}
+
+/// <summary>
+/// Returns the clipmap center relative to the water origin. It is snapped to twice the coarsest spacing
+/// so every level stays on its own lattice and the vertices don't swim when the focus moves.
+/// </summary>
+/// <returns></returns>
+FVector2D UGerstnerWaveComponent::GetClipmapCenter() const
+{
+    const FVector2D localFocus = FVector2D(GetFocusLocation()) - Origin2D;
+    const float snap = ClipmapBaseSpacing * (1 << ClipmapLevels);
+    return FVector2D(FMath::GridSnap(localFocus.X, snap), FMath::GridSnap(localFocus.Y, snap));
+}
+
+/// <summary>
+/// Creates one instance per tile of the ring. The instances only ever move, so the render data is built once.
+/// </summary>
+void UGerstnerWaveComponent::CreateTiles()
+{
+    if (OceanTileMesh == nullptr)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("bUseInstancedTiles is set but no OceanTileMesh is assigned on %s"), *GetName());
+        return;
+    }
+    TileInstances = NewObject<UInstancedStaticMeshComponent>(GetOwner());
+    TileInstances->SetStaticMesh(OceanTileMesh);
+    if (OceanMaterial)
+    {
+        TileInstances->SetMaterial(0, OceanMaterial);
+    }
+    TileInstances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+    TileInstances->SetMobility(EComponentMobility::Movable);
+    TileInstances->RegisterComponent();
+    TileInstances->AttachToComponent(GetOwner()->GetRootComponent(), FAttachmentTransformRules::KeepRelativeTransform);
+
+    const int32 tilesPerSide = 2 * TileRings + 1;
+    TArray<FTransform> transforms;
+    transforms.Init(FTransform::Identity, tilesPerSide * tilesPerSide);
+    TileInstances->AddInstances(transforms, false);
+    ProcMesh->SetVisibility(false);
+    UpdateTiles();
+}
+
+/// <summary>
+/// Moves the ring of tiles when the focus enters another tile. Tiles are placed on a fixed lattice,
+/// the material evaluates the waves from the world position so neighbouring tiles line up.
+/// </summary>
+void UGerstnerWaveComponent::UpdateTiles()
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(UGerstnerWaveComponent::UpdateTiles);
+    const FVector2D localFocus = FVector2D(GetFocusLocation()) - Origin2D;
+    const FIntPoint centerCell(FMath::RoundToInt32(localFocus.X / OceanTileSize), FMath::RoundToInt32(localFocus.Y / OceanTileSize));
+    if (centerCell == TileCenterCell)
+    {
+        return;
+    }
+    TileCenterCell = centerCell;
+
+    const int32 tilesPerSide = 2 * TileRings + 1;
+    TArray<FTransform> transforms;
+    transforms.Reserve(tilesPerSide * tilesPerSide);
+    for (int32 y = -TileRings; y <= TileRings; ++y)
+    {
+        for (int32 x = -TileRings; x <= TileRings; ++x)
+        {
+            transforms.Add(FTransform(FVector((centerCell.X + x) * OceanTileSize, (centerCell.Y + y) * OceanTileSize, 0)));
+        }
+    }
+    TileInstances->BatchUpdateInstancesTransforms(0, transforms, false, true);
+}
+
 //FWaterSample UGerstnerWaveComponent::SampleHeightAt(const FVector2D& WorldXY, float time) const
 //{
 //    FVector2D LocalXY = WorldXY - FVector2D(GetOwner()->GetActorLocation());
@@ -334,5 +556,197 @@ void UGerstnerWaveComponent::TickComponent(
 {
     TRACE_CPUPROFILER_EVENT_SCOPE(UGerstnerWaveComponent::TickComponent);
     Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+    if (TileInstances != nullptr)
+    {
+        UpdateTiles();
+        // The tiles displace themselves on the GPU, the hidden grid only needs to follow the waves for its collision
+        if (!bCookCollision)
+        {
+            return;
+        }
+    }
+    if (!bUpdateMeshOnCPU || ProcMesh == nullptr || OriginalVerts.Num() == 0)
+    {
+        return;
+    }
+
+    // Push the buffers the workers filled during the previous frame, then start on the other pair
+    if (MeshUpdateTask.IsValid())
+    {
+        MeshUpdateTask.Wait();
+        ProcMesh->UpdateMeshSection_LinearColor(0, MeshPositions[MeshWriteBuffer], MeshNormals[MeshWriteBuffer],
+            MeshUVs[MeshWriteBuffer], TArray<FLinearColor>(), TArray<FProcMeshTangent>());
+        MeshWriteBuffer ^= 1;
+    }
+
+    // The result is displayed next frame, so evaluate the waves at the time it will be shown
+    const float displayTime = GetWorld()->GetTimeSeconds() + DeltaTime;
+    const int32 bufferIndex = MeshWriteBuffer;
+    const FVector2D gridCenter = bUseClipmap ? GetClipmapCenter() : FVector2D::ZeroVector;
+    MeshUpdateTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, [this, bufferIndex, displayTime, gridCenter]
+        {
+            UpdateMeshBuffers(bufferIndex, displayTime, gridCenter);
+        });
 }
 
+void UGerstnerWaveComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    // The workers write into our buffers, they must be done before the component goes away
+    if (MeshUpdateTask.IsValid())
+    {
+        MeshUpdateTask.Wait();
+    }
+    Super::EndPlay(EndPlayReason);
+}
+
+/// <summary>
+/// Displaces the grid vertices and computes their normals for the given time into one half of the double buffer.
+/// The vertices are split into chunks that are processed in parallel, heights come from the same batched sampler as the physics.
+/// OriginalVerts are offsets from gridCenter, which is zero for the uniform grid and the snapped focus for the clipmap.
+/// When a mesh height source is set its positions and normals are used as they are.
+/// With the phasor cache the waves are advanced from the previous update instead of being evaluated from scratch,
+/// when the clipmap moves the cached phasors are rotated by the offset instead of being seeded again.
+/// Each level only sums the waves needed to stay within Tolerance, doubled per clipmap level. The outer edge of a level
+/// lies on the inner edge of the next one, so it sums the waves of the next level and both rings agree where they meet.
+/// </summary>
+/// <param name="bufferIndex"></param>
+/// <param name="time"></param>
+/// <param name="gridCenter"></param>
+void UGerstnerWaveComponent::UpdateMeshBuffers(int32 bufferIndex, float time, FVector2D gridCenter)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(UGerstnerWaveComponent::UpdateMeshBuffers);
+    TArray<FVector>& positions = MeshPositions[bufferIndex];
+    TArray<FVector>& normals = MeshNormals[bufferIndex];
+    check(positions.Num() == OriginalVerts.Num() && normals.Num() == OriginalVerts.Num());
+
+    // At least one full sample block per chunk. Neighbouring chunks may share the cache line at their boundary,
+    // a chunk writes thousands of bytes so that one line doesn't matter
+    const int32 chunkSize = FMath::Max(MeshUpdateChunkSize, 64);
+    const int32 numChunks = FMath::DivideAndRoundUp(OriginalVerts.Num(), chunkSize);
+    const IWaterSurface& heightSource = MeshHeightSource != nullptr ? *MeshHeightSource : static_cast<const IWaterSurface&>(*this);
+    const bool useOwnWaves = MeshHeightSource == nullptr;
+    const bool usePhasors = useOwnWaves && bUseWavePhasors;
+
+    // Every level is twice as coarse as the one inside it, so it can afford twice the height error
+    auto levelTolerance = [this](int32 level) { return Tolerance * (1 << level); };
+    TArray<int32, TInlineAllocator<16>> levelWaveCounts;
+    for (int32 level = 0; level + 1 < MeshLevelStarts.Num(); ++level)
+    {
+        levelWaveCounts.Add(GetCompiledWaves().NumWavesForTolerance(levelTolerance(level)));
+    }
+
+    if (usePhasors)
+    {
+        // The phasors of the waves a level skips are not advanced, so the cache is seeded again when the counts change
+        if (!MeshPhasors.IsValidFor(GetCompiledWaves(), OriginalVerts.Num()) || PhasorWaveCounts != levelWaveCounts)
+        {
+            PhasorWaveCounts = levelWaveCounts;
+            TArray<FVector2D> localXY;
+            localXY.SetNumUninitialized(OriginalVerts.Num());
+            for (int32 i = 0; i < OriginalVerts.Num(); ++i)
+            {
+                localXY[i] = gridCenter + FVector2D{ OriginalVerts[i].X, OriginalVerts[i].Y };
+            }
+            MeshPhasors.Initialize(GetCompiledWaves(), localXY, time);
+        }
+        else if (gridCenter != PhasorGridCenter)
+        {
+            MeshPhasors.Translate(gridCenter - PhasorGridCenter);
+        }
+        PhasorGridCenter = gridCenter;
+        MeshPhasors.BeginStep(time);
+    }
+
+    auto updateRange = [&](int32 rangeStart, int32 rangeEnd, int32 level)
+        {
+            constexpr int32 SampleBlockSize = 64;
+            if (usePhasors)
+            {
+                float heights[SampleBlockSize];
+                for (int32 blockStart = rangeStart; blockStart < rangeEnd; blockStart += SampleBlockSize)
+                {
+                    const int32 blockCount = FMath::Min(SampleBlockSize, rangeEnd - blockStart);
+                    MeshPhasors.StepPoints(blockStart, blockCount, levelWaveCounts[level], MakeArrayView(heights, blockCount), TArrayView<FVector>(&normals[blockStart], blockCount));
+                    for (int32 i = 0; i < blockCount; ++i)
+                    {
+                        // Same bounds as the sampler, so the mesh doesn't change shape when the phasors are turned off
+                        const FVector2D localXY = gridCenter + FVector2D{ OriginalVerts[blockStart + i].X, OriginalVerts[blockStart + i].Y };
+                        positions[blockStart + i] = FVector{ localXY.X, localXY.Y, IsInsideGrid(localXY.X, localXY.Y) ? heights[i] : 0.0f };
+                    }
+                }
+                return;
+            }
+
+            FVector2D worldXY[SampleBlockSize];
+            FWaterSample waterSamples[SampleBlockSize];
+            for (int32 blockStart = rangeStart; blockStart < rangeEnd; blockStart += SampleBlockSize)
+            {
+                const int32 blockCount = FMath::Min(SampleBlockSize, rangeEnd - blockStart);
+                for (int32 i = 0; i < blockCount; ++i)
+                {
+                    worldXY[i] = Origin2D + gridCenter + FVector2D{ OriginalVerts[blockStart + i].X, OriginalVerts[blockStart + i].Y };
+                }
+                heightSource.SampleHeightsApprox(MakeArrayView(worldXY, blockCount), time, levelTolerance(level), MakeArrayView(waterSamples, blockCount));
+                for (int32 i = 0; i < blockCount; ++i)
+                {
+                    // The mesh is relative to the owner so the height is stored relative to the base of the water
+                    const float height = waterSamples[i].IsValid ? waterSamples[i].Position.Z - BaseZ : 0.0f;
+                    if (useOwnWaves)
+                    {
+                        const FVector2D localXY = worldXY[i] - Origin2D;
+                        positions[blockStart + i] = FVector{ localXY.X, localXY.Y, height };
+                    }
+                    else
+                    {
+                        // Other surfaces may move the point sideways and bring their own normal
+                        const FVector2D localXY = (waterSamples[i].IsValid ? FVector2D(waterSamples[i].Position) : worldXY[i]) - Origin2D;
+                        positions[blockStart + i] = FVector{ localXY.X, localXY.Y, height };
+                        normals[blockStart + i] = waterSamples[i].IsValid ? waterSamples[i].Normal : FVector::UpVector;
+                    }
+                }
+            }
+            if (!useOwnWaves)
+            {
+                return;
+            }
+            ComputeGerstnerNormals(TArrayView<const FVector>(&OriginalVerts[rangeStart], rangeEnd - rangeStart), gridCenter, GetCompiledWaves(),
+                levelWaveCounts[level], time, TArrayView<FVector>(&normals[rangeStart], rangeEnd - rangeStart));
+        };
+    ParallelFor(numChunks, [&](int32 chunk)
+        {
+            const int32 chunkStart = chunk * chunkSize;
+            const int32 chunkEnd = FMath::Min(chunkStart + chunkSize, OriginalVerts.Num());
+            // A chunk can straddle two levels, each part is evaluated with the tolerance of its own level,
+            // or of the next level for the outer edge
+            const int32 lastLevel = MeshLevelStarts.Num() - 2;
+            for (int32 level = 0; level <= lastLevel; ++level)
+            {
+                const int32 ranges[3] = { MeshLevelStarts[level], MeshLevelOuterStarts[level], MeshLevelStarts[level + 1] };
+                for (int32 part = 0; part < 2; ++part)
+                {
+                    const int32 rangeStart = FMath::Max(chunkStart, ranges[part]);
+                    const int32 rangeEnd = FMath::Min(chunkEnd, ranges[part + 1]);
+                    if (rangeStart < rangeEnd)
+                    {
+                        updateRange(rangeStart, rangeEnd, FMath::Min(level + part, lastLevel));
+                    }
+                }
+            }
+        });
+
+    if (ClipmapStitches.Num() > 0)
+    {
+        // Pull the mid-edge vertices onto the coarser ring's edge so the rings meet without cracks
+        for (const FIntVector& stitch : ClipmapStitches)
+        {
+            positions[stitch.X].Z = 0.5f * (positions[stitch.Y].Z + positions[stitch.Z].Z);
+        }
+        TArray<FVector2D>& uvs = MeshUVs[bufferIndex];
+        const float uvScale = GridWorldSize > 0 ? 1.0f / GridWorldSize : 0.0f;
+        for (int32 i = 0; i < positions.Num(); ++i)
+        {
+            uvs[i] = FVector2D{ positions[i].X, positions[i].Y } * uvScale;
+        }
+    }
+}
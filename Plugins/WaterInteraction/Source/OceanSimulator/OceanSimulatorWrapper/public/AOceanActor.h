@@ -28,4 +28,11 @@ public:
     USceneComponent* OceanRoot;
     UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Boat|Components")
     UGerstnerWaveComponent* GerstnerWaveComponent;
+
+    // The surface the physics should sample, the FFT ocean when one is added to the actor and the Gerstner waves otherwise
+    IWaterSurface* GetWaterSurface() const;
+
+    // Traces a segment against the current water surface without any physics collision
+    UFUNCTION(BlueprintCallable, Category = "Ocean")
+    bool TraceWater(const FVector& Start, const FVector& End, FVector& HitLocation, FVector& HitNormal) const;
 };
\ No newline at end of file
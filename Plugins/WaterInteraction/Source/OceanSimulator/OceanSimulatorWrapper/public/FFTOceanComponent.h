@@ -0,0 +1,52 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "SpectrumWaterSurface.h"
+#include "Tasks/Task.h"
+#include "FFTOceanComponent.generated.h"
+
+/**
+ * Water surface synthesized from a wind driven wave spectrum instead of a handful of Gerstner waves.
+ * A new heightfield is synthesized on a worker every frame, the samplers read the last published one.
+ * When it is on the same actor as the Gerstner component it replaces it for the physics and drives the CPU mesh.
+ */
+UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
+class OCEANSIMULATORWRAPPER_API UFFTOceanComponent : public UActorComponent, public SpectrumWaterSurfaceCore
+{
+    GENERATED_BODY()
+
+public:
+    UFFTOceanComponent();
+
+    // Samples along each side of the heightfield, rounded to a power of two between 16 and 1024
+    UPROPERTY(EditAnywhere, Category = "Spectrum", meta = (ClampMin = "16", ClampMax = "1024"))
+    int32 Resolution = 256;
+    // Size of the heightfield in cm before it repeats
+    UPROPERTY(EditAnywhere, Category = "Spectrum", meta = (ClampMin = "100.0"))
+    float PatchSize = 50000.0f;
+    // Wind speed in m/s, sets the size of the largest waves
+    UPROPERTY(EditAnywhere, Category = "Spectrum", meta = (ClampMin = "0.1"))
+    float WindSpeed = 10.0f;
+    UPROPERTY(EditAnywhere, Category = "Spectrum")
+    FVector2D WindDirection = FVector2D(1.0f, 0.0f);
+    // Multiplier on the wave height of a fully developed sea for the wind speed
+    UPROPERTY(EditAnywhere, Category = "Spectrum", meta = (ClampMin = "0.0"))
+    float Amplitude = 1.0f;
+    // Horizontal displacement scale, sharpens the crests
+    UPROPERTY(EditAnywhere, Category = "Spectrum", meta = (ClampMin = "0.0"))
+    float Choppiness = 1.0f;
+    // Waves much shorter than this many cm are suppressed
+    UPROPERTY(EditAnywhere, Category = "Spectrum", meta = (ClampMin = "0.0"))
+    float SmallWaveCutoff = 10.0f;
+    UPROPERTY(EditAnywhere, Category = "Spectrum")
+    int32 Seed = 1;
+
+protected:
+    virtual void BeginPlay() override;
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+    virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+private:
+    UE::Tasks::FTask SynthesizeTask;
+};
\ No newline at end of file
@@ -7,6 +7,8 @@
 #include "WaterSample.h"
 #include "WaveInfo.h"
 #include "WaterSurface.h"
+#include "WavePhasorCache.h"
+#include "Tasks/Task.h"
 #include "GerstnerWaveComponent.generated.h"
 
 /**
@@ -31,20 +33,98 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Gerstner")
     UMaterialInterface* OceanMaterial = nullptr;
 
-    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Gerstner")
+    // Height error in cm the ocean mesh may have, the smallest waves are left out while they add up to less than this.
+    // Doubled for every clipmap level. 0 always sums every wave. The physics always uses every wave.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Gerstner", meta = (ClampMin = "0.0"))
     float Tolerance = 1.0f;
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Gerstner")
     UMaterialParameterCollection* WavesMaterialParameterCollection;
+    // Sample the waves everywhere instead of only over the grid, so boats keep their forces when they leave it
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Gerstner")
+    bool bUnboundedWater = false;
+    // Cook a physics trimesh for the ocean mesh. Off by default, the analytic trace on the ocean actor hits the real waves
+    // and doesn't cost any cooking time at startup.
+    UPROPERTY(EditAnywhere, Category = "Gerstner")
+    bool bCookCollision = false;
+
+    // Displace the ocean mesh on the CPU so that the rendered and collision mesh match the physics waves.
+    // Leave this off when the ocean material already displaces the vertices.
+    UPROPERTY(EditAnywhere, Category = "Gerstner|Mesh Update")
+    bool bUpdateMeshOnCPU = false;
+    // Number of vertices each worker task displaces at once
+    UPROPERTY(EditAnywhere, Category = "Gerstner|Mesh Update", meta = (EditCondition = "bUpdateMeshOnCPU", ClampMin = "64"))
+    int32 MeshUpdateChunkSize = 4096;
+    // Advance the cached phase of every wave at every vertex each update instead of evaluating sin and cos per vertex.
+    // Costs 8 bytes per wave and vertex.
+    UPROPERTY(EditAnywhere, Category = "Gerstner|Mesh Update", meta = (EditCondition = "bUpdateMeshOnCPU"))
+    bool bUseWavePhasors = true;
+
+    // Replace the uniform grid with nested rings that follow the focus, fine near it and twice as coarse per ring outwards.
+    UPROPERTY(EditAnywhere, Category = "Gerstner|Clipmap", meta = (EditCondition = "bUpdateMeshOnCPU"))
+    bool bUseClipmap = false;
+    UPROPERTY(EditAnywhere, Category = "Gerstner|Clipmap", meta = (EditCondition = "bUpdateMeshOnCPU && bUseClipmap", ClampMin = "1", ClampMax = "12"))
+    int32 ClipmapLevels = 5;
+    // Cells along each side of a ring, rounded up to a multiple of 4
+    UPROPERTY(EditAnywhere, Category = "Gerstner|Clipmap", meta = (EditCondition = "bUpdateMeshOnCPU && bUseClipmap", ClampMin = "8"))
+    int32 ClipmapLevelResolution = 64;
+    // Vertex spacing of the finest ring in cm
+    UPROPERTY(EditAnywhere, Category = "Gerstner|Clipmap", meta = (EditCondition = "bUpdateMeshOnCPU && bUseClipmap", ClampMin = "1.0"))
+    float ClipmapBaseSpacing = 100.0f;
+    // Actor the rings are centred on, the player camera is used when this is not set
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Gerstner|Clipmap", meta = (EditCondition = "bUpdateMeshOnCPU && bUseClipmap"))
+    AActor* ClipmapFocusActor = nullptr;
+
+    // Render the ocean as rings of instanced tiles around the focus instead of the procedural grid.
+    // All tiles share the mesh's vertex buffer and are animated by the ocean material from the wave parameter collection.
+    // The procedural grid is hidden, it only keeps its collision when bCookCollision is set.
+    UPROPERTY(EditAnywhere, Category = "Gerstner|Tiles")
+    bool bUseInstancedTiles = false;
+    // Flat tile, centred on its pivot and OceanTileSize across. Needs enough vertices for the material to displace.
+    UPROPERTY(EditAnywhere, Category = "Gerstner|Tiles", meta = (EditCondition = "bUseInstancedTiles"))
+    class UStaticMesh* OceanTileMesh = nullptr;
+    UPROPERTY(EditAnywhere, Category = "Gerstner|Tiles", meta = (EditCondition = "bUseInstancedTiles", ClampMin = "100.0"))
+    float OceanTileSize = 10000.0f;
+    // Tiles on each side of the focus tile, the ring covers (2 * TileRings + 1)^2 tiles
+    UPROPERTY(EditAnywhere, Category = "Gerstner|Tiles", meta = (EditCondition = "bUseInstancedTiles", ClampMin = "0", ClampMax = "32"))
+    int32 TileRings = 4;
+
+    // Displace the CPU mesh with another water surface instead of the Gerstner waves, nullptr goes back to the waves.
+    // The surface must outlive this component.
+    void SetMeshHeightSource(const IWaterSurface* source) { MeshHeightSource = source; }
 
 protected:
     virtual void BeginPlay() override;
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
     virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
 
 private:
     class UProceduralMeshComponent* ProcMesh;
     TArray<FVector> OriginalVerts;
-    TArray<TArray<float>> HeightMap;
-    TArray<TArray<FVector>> NormalMap;
+    // Double buffered vertex data, the workers fill one pair while the other is pushed to the mesh.
+    // Sized once in GenerateGrid and never reallocated afterwards.
+    TArray<FVector> MeshPositions[2];
+    TArray<FVector> MeshNormals[2];
+    TArray<FVector2D> MeshUVs[2]; // Only used by the clipmap, the uniform grid keeps its UVs
+    int32 MeshWriteBuffer = 0;
+    UE::Tasks::FTask MeshUpdateTask;
+    // Clipmap ring vertices that sit in the middle of a coarser ring's edge (X) and the two vertices they are blended from (Y,Z)
+    TArray<FIntVector> ClipmapStitches;
+    // First vertex of every LOD level plus the vertex count at the end, the uniform grid is a single level
+    TArray<int32> MeshLevelStarts;
+    // One per level, first vertex of its outer edge, which is evaluated with the waves of the next level
+    TArray<int32> MeshLevelOuterStarts;
+    const IWaterSurface* MeshHeightSource = nullptr;
+    WavePhasorCache MeshPhasors;
+    FVector2D PhasorGridCenter = FVector2D::ZeroVector;
+    TArray<int32, TInlineAllocator<16>> PhasorWaveCounts; // Waves per level the phasors were stepped with
+    class UInstancedStaticMeshComponent* TileInstances = nullptr;
+    FIntPoint TileCenterCell = FIntPoint(MAX_int32, MAX_int32);
 
     void GenerateGrid();
+    void BuildClipmapLayout(TArray<int32>& Triangles);
+    FVector GetFocusLocation() const;
+    FVector2D GetClipmapCenter() const;
+    void CreateTiles();
+    void UpdateTiles();
+    void UpdateMeshBuffers(int32 bufferIndex, float time, FVector2D gridCenter);
 };